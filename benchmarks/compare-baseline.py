@@ -0,0 +1,120 @@
+#!/usr/bin/env python
+#
+# Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+"""Compare QTestLib XML benchmark results against a stored baseline.
+
+The baseline is a JSON object mapping "function/tag" to the measured value
+per iteration. Exits with a non-zero status if any benchmark got slower
+than the given threshold or if a benchmark has no baseline value yet
+(unless --allow-new is given). Without a baseline the comparison is
+skipped, unless --require-baseline is given.
+"""
+
+import argparse
+import json
+import os
+import sys
+import xml.etree.ElementTree as ElementTree
+
+
+def read_results(path):
+    results = {}
+    root = ElementTree.parse(path).getroot()
+    for function in root.iter('TestFunction'):
+        for result in function.iter('BenchmarkResult'):
+            name = function.get('name')
+            tag = result.get('tag')
+            if tag:
+                name = '%s/%s' % (name, tag)
+            value = float(result.get('value'))
+            iterations = int(result.get('iterations', '1')) or 1
+            results[name] = {
+                'metric': result.get('metric'),
+                'value': value / iterations,
+            }
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('baseline')
+    parser.add_argument('results')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='allowed slowdown in percent (default: 10)')
+    parser.add_argument('--update', action='store_true',
+                        help='store the results as new baseline')
+    parser.add_argument('--allow-new', action='store_true',
+                        help='do not fail for benchmarks missing in the baseline')
+    parser.add_argument('--require-baseline', action='store_true',
+                        help='fail instead of skipping the comparison without a baseline')
+    args = parser.parse_args()
+
+    results = read_results(args.results)
+
+    if args.update:
+        with open(args.baseline, 'w') as f:
+            json.dump(results, f, indent=4, sort_keys=True)
+            f.write('\n')
+        print('Stored %d results in %s' % (len(results), args.baseline))
+        return 0
+
+    if not os.path.exists(args.baseline):
+        if args.require_baseline:
+            sys.stderr.write('ERROR: No baseline at %s, nothing to compare against.\n' % args.baseline)
+        else:
+            sys.stderr.write('WARNING: No baseline at %s, skipping the comparison.\n' % args.baseline)
+        sys.stderr.write('Create one on the reference device with "make benchmark-update-baseline".\n')
+        return 2 if args.require_baseline else 0
+
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+
+    regressions = 0
+    unknown = 0
+    for name in sorted(results):
+        current = results[name]
+        reference = baseline.get(name)
+        if reference is None:
+            print('%-60s %12.4f %s (not in baseline)' % (name, current['value'], current['metric']))
+            unknown += 1
+            continue
+
+        if reference['value'] > 0:
+            change = (current['value'] - reference['value']) * 100.0 / reference['value']
+        else:
+            change = 0.0
+
+        status = ''
+        if change > args.threshold:
+            status = 'REGRESSION'
+            regressions += 1
+
+        print('%-60s %12.4f %s %+7.1f%% %s' % (name, current['value'],
+                                              current['metric'], change, status))
+
+    for name in sorted(set(baseline) - set(results)):
+        print('%-60s missing' % name)
+
+    if unknown > 0 and not args.allow_new:
+        sys.stderr.write('ERROR: %d benchmarks have no baseline value, update the baseline\n' % unknown)
+        return 1
+
+    return 1 if regressions > 0 else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
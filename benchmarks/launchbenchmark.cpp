@@ -0,0 +1,485 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * Launches the fixture applications through the in-process transport and
+ * measures the time to LoadSucceeded, stageReady and the first frame.
+ *
+ * Cold runs start a fresh manager process per launch, warm runs launch the
+ * same application repeatedly within one manager. Rendering happens on the
+ * offscreen platform so no compositor or GPU is needed.
+ */
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+
+#include <algorithm>
+
+#include <stdlib.h>
+
+#include "localservicetransport.h"
+#include "memoryusage.h"
+#include "webappmanager.h"
+#include "webapplication.h"
+#include "webapplicationwindow.h"
+
+using namespace luna;
+
+#define FIRST_FRAME_GRACE_PERIOD    1000
+
+/*
+ * Serves the fixture of the remote application so it's loaded over the
+ * network stack like a real remote entry point.
+ */
+class HttpStandIn : public QTcpServer
+{
+    Q_OBJECT
+public:
+    HttpStandIn(const QString &documentRoot, QObject *parent = 0) :
+        QTcpServer(parent),
+        mDocumentRoot(documentRoot)
+    {
+        connect(this, SIGNAL(newConnection()), this, SLOT(onNewConnection()));
+    }
+
+private Q_SLOTS:
+    void onNewConnection()
+    {
+        while (QTcpSocket *socket = nextPendingConnection()) {
+            connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+            connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+        }
+    }
+
+    void onReadyRead()
+    {
+        QTcpSocket *socket = static_cast<QTcpSocket*>(sender());
+
+        if (!socket->canReadLine())
+            return;
+
+        QList<QByteArray> request = socket->readLine().trimmed().split(' ');
+        QString path = request.size() > 1 ? QString(request.at(1)) : QString("/");
+        if (path == "/")
+            path = "/index.html";
+
+        QFile file(mDocumentRoot + path);
+        QByteArray response;
+
+        if (!path.contains("..") && file.open(QIODevice::ReadOnly)) {
+            QByteArray content = file.readAll();
+            response = "HTTP/1.0 200 OK\r\nContent-Type: text/html\r\nContent-Length: " +
+                       QByteArray::number(content.size()) + "\r\n\r\n" + content;
+        }
+        else {
+            response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        }
+
+        socket->write(response);
+        socket->disconnectFromHost();
+    }
+
+private:
+    QString mDocumentRoot;
+};
+
+class LaunchBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    LaunchBenchmark(WebAppManager *manager, LocalServiceTransport *transport,
+                    const QString &fixturesPath, int timeout) :
+        mManager(manager),
+        mTransport(transport),
+        mFixturesPath(fixturesPath),
+        mHttp(fixturesPath + "/remote"),
+        mTimeout(timeout),
+        mIterations(0),
+        mProcessId(1000),
+        mWindow(0)
+    {
+        mTimeoutTimer.setSingleShot(true);
+        connect(&mTimeoutTimer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+
+        mSampleTimer.setInterval(50);
+        connect(&mSampleTimer, SIGNAL(timeout()), this, SLOT(onSampleMemory()));
+
+        mCloseTimer.setInterval(50);
+        connect(&mCloseTimer, SIGNAL(timeout()), this, SLOT(onCheckClosed()));
+
+        mHttp.listen(QHostAddress::LocalHost);
+    }
+
+    void run(const QString &fixture, int iterations)
+    {
+        mFixture = fixture;
+        mIterations = iterations;
+        mRuns = QJsonArray();
+
+        QMetaObject::invokeMethod(this, "onLaunch", Qt::QueuedConnection);
+    }
+
+    QJsonArray runs() const
+    {
+        return mRuns;
+    }
+
+Q_SIGNALS:
+    void finished();
+
+private Q_SLOTS:
+    void onLaunch()
+    {
+        mAppId = QString("org.webosports.benchmark.%1").arg(mFixture);
+        mLoadSucceeded = mStageReady = mFirstFrame = -1;
+        mPeakWebProcessMemory = 0;
+
+        QString entryPoint = QString("%1/%2/index.html").arg(mFixturesPath).arg(mFixture);
+        if (mFixture == "remote")
+            entryPoint = QString("http://127.0.0.1:%1/index.html").arg(mHttp.serverPort());
+
+        QJsonObject desc;
+        desc.insert("id", mAppId);
+        desc.insert("title", mFixture);
+        desc.insert("main", entryPoint);
+
+        QJsonObject payload;
+        payload.insert("appDesc", desc);
+        payload.insert("params", QJsonObject());
+        payload.insert("processId", mProcessId++);
+
+        mElapsed.start();
+        mSampleTimer.start();
+        mTimeoutTimer.start(mTimeout);
+
+        mTransport->call("launchApp", QJsonDocument(payload).toJson(QJsonDocument::Compact),
+                         [this](const QByteArray &response) {
+            Q_UNUSED(response);
+            onLaunchResponse();
+        });
+    }
+
+    void onLoadSucceeded()
+    {
+        if (mLoadSucceeded < 0)
+            mLoadSucceeded = mElapsed.nsecsElapsed();
+        checkDone();
+    }
+
+    void onReadyChanged()
+    {
+        if (mStageReady < 0 && mWindow->ready())
+            mStageReady = mElapsed.nsecsElapsed();
+        checkDone();
+    }
+
+    void onFirstFrameSwapped()
+    {
+        if (mFirstFrame < 0)
+            mFirstFrame = mElapsed.nsecsElapsed();
+        checkDone();
+    }
+
+    void onApplicationLaunched()
+    {
+        WebApplication *application = static_cast<WebApplication*>(sender());
+        disconnect(application, 0, this, 0);
+
+        mWindow = application->mainWindow();
+
+        connect(mWindow, SIGNAL(loadSucceeded()), this, SLOT(onLoadSucceeded()));
+        connect(mWindow, SIGNAL(readyChanged()), this, SLOT(onReadyChanged()));
+        connect(mWindow, SIGNAL(firstFrameSwapped()), this, SLOT(onFirstFrameSwapped()));
+    }
+
+    void onTimeout()
+    {
+        finishIteration();
+    }
+
+    void onSampleMemory()
+    {
+        mPeakWebProcessMemory = qMax(mPeakWebProcessMemory, childrenResidentMemory());
+    }
+
+    void onCheckClosed()
+    {
+        if (mManager->isAppRunning(mAppId))
+            return;
+
+        mCloseTimer.stop();
+
+        if (--mIterations > 0)
+            onLaunch();
+        else
+            Q_EMIT finished();
+    }
+
+private:
+    void onLaunchResponse()
+    {
+        WebApplication *application = 0;
+
+        Q_FOREACH(WebApplication *app, mManager->applications()) {
+            if (app->id() == mAppId)
+                application = app;
+        }
+
+        if (!application) {
+            qWarning("Failed to launch fixture %s", mFixture.toUtf8().constData());
+            finishIteration();
+            return;
+        }
+
+        // The window is only constructed after the launch was acknowledged
+        connect(application, SIGNAL(launched()), this, SLOT(onApplicationLaunched()));
+        connect(application, SIGNAL(launchFailed()), this, SLOT(onTimeout()));
+    }
+
+    void checkDone()
+    {
+        if (mLoadSucceeded < 0 || mStageReady < 0)
+            return;
+
+        if (mFirstFrame >= 0) {
+            finishIteration();
+            return;
+        }
+
+        // Without any OpenGL implementation the offscreen platform never
+        // renders so only wait a bit longer for the first frame
+        mTimeoutTimer.start(qMin(mTimeoutTimer.remainingTime(), FIRST_FRAME_GRACE_PERIOD));
+    }
+
+    void finishIteration()
+    {
+        mTimeoutTimer.stop();
+        onSampleMemory();
+        mSampleTimer.stop();
+
+        if (mWindow) {
+            disconnect(mWindow, 0, this, 0);
+            mWindow = 0;
+        }
+
+        Q_FOREACH(WebApplication *app, mManager->applications())
+            disconnect(app, 0, this, 0);
+
+        QJsonObject run;
+        run.insert("loadSucceeded", toMilliseconds(mLoadSucceeded));
+        run.insert("stageReady", toMilliseconds(mStageReady));
+        run.insert("firstFrame", toMilliseconds(mFirstFrame));
+        run.insert("peakWebProcessMemory", mPeakWebProcessMemory);
+        run.insert("peakManagerMemory", peakResidentMemory());
+        mRuns.append(run);
+
+        QJsonObject payload;
+        payload.insert("appId", mAppId);
+        mTransport->call("killApp", QJsonDocument(payload).toJson(QJsonDocument::Compact),
+                         LocalServiceTransport::ResponseHandler());
+
+        mCloseTimer.start();
+    }
+
+    static double toMilliseconds(qint64 nsecs)
+    {
+        return nsecs < 0 ? -1.0 : nsecs / 1000000.0;
+    }
+
+    WebAppManager *mManager;
+    LocalServiceTransport *mTransport;
+    QString mFixturesPath;
+    HttpStandIn mHttp;
+    QString mFixture;
+    QString mAppId;
+    int mTimeout;
+    int mIterations;
+    int mProcessId;
+    WebApplicationWindow *mWindow;
+    QElapsedTimer mElapsed;
+    QTimer mTimeoutTimer;
+    QTimer mSampleTimer;
+    QTimer mCloseTimer;
+    qint64 mLoadSucceeded;
+    qint64 mStageReady;
+    qint64 mFirstFrame;
+    qint64 mPeakWebProcessMemory;
+    QJsonArray mRuns;
+};
+
+static double median(const QJsonArray &runs, const QString &key)
+{
+    QVector<double> values;
+    Q_FOREACH(const QJsonValue &run, runs) {
+        double value = run.toObject().value(key).toDouble();
+        if (value >= 0)
+            values.append(value);
+    }
+
+    if (values.isEmpty())
+        return -1;
+
+    std::sort(values.begin(), values.end());
+    return values.at(values.size() / 2);
+}
+
+static QJsonObject summarize(const QJsonArray &runs)
+{
+    QJsonObject summary;
+    summary.insert("runs", runs);
+    summary.insert("loadSucceeded", median(runs, "loadSucceeded"));
+    summary.insert("stageReady", median(runs, "stageReady"));
+    summary.insert("firstFrame", median(runs, "firstFrame"));
+    summary.insert("peakWebProcessMemory", median(runs, "peakWebProcessMemory"));
+    summary.insert("peakManagerMemory", median(runs, "peakManagerMemory"));
+    return summary;
+}
+
+static QJsonArray runCold(const QString &fixture, int iterations, const QStringList &options)
+{
+    QJsonArray runs;
+
+    for (int n = 0; n < iterations; n++) {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        process.start(QCoreApplication::applicationFilePath(),
+                      QStringList() << options << "--child" << "--fixtures-only" << fixture);
+
+        if (!process.waitForFinished(60000)) {
+            process.kill();
+            qWarning("Cold run of fixture %s timed out", fixture.toUtf8().constData());
+            continue;
+        }
+
+        QJsonDocument document = QJsonDocument::fromJson(process.readAllStandardOutput());
+        Q_FOREACH(const QJsonValue &run, document.array())
+            runs.append(run);
+    }
+
+    return runs;
+}
+
+int main(int argc, char **argv)
+{
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    QTemporaryDir storage;
+    setenv("XDG_DATA_HOME", QString("%1/data").arg(storage.path()).toUtf8().constData(), 0);
+    setenv("XDG_CACHE_HOME", QString("%1/cache").arg(storage.path()).toUtf8().constData(), 0);
+
+    LocalServiceTransport *transport = new LocalServiceTransport;
+    WebAppManager webAppManager(argc, argv, transport);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Launch latency benchmark for the web application manager");
+    parser.addHelpOption();
+
+    QCommandLineOption iterationsOption("iterations", "Launches per fixture and mode", "count", "5");
+    QCommandLineOption fixturesOption("fixtures", "Directory containing the fixture applications", "path", FIXTURES_DIR);
+    QCommandLineOption onlyOption("fixtures-only", "Comma separated list of fixtures to run", "names", "minimal,mojo,enyo,remote");
+    QCommandLineOption modeOption("mode", "cold, warm or both", "mode", "both");
+    QCommandLineOption timeoutOption("timeout", "Time to wait for a launch to complete in ms", "ms", "10000");
+    QCommandLineOption outputOption("output", "Write the JSON report to a file", "path");
+    QCommandLineOption childOption("child", "Internal: run a single cold launch");
+
+    parser.addOption(iterationsOption);
+    parser.addOption(fixturesOption);
+    parser.addOption(onlyOption);
+    parser.addOption(modeOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(outputOption);
+    parser.addOption(childOption);
+    parser.process(webAppManager);
+
+    QStringList fixtures = parser.value(onlyOption).split(',', QString::SkipEmptyParts);
+    QString mode = parser.value(modeOption);
+    int iterations = qMax(1, parser.value(iterationsOption).toInt());
+
+    LaunchBenchmark benchmark(&webAppManager, transport, parser.value(fixturesOption),
+                              parser.value(timeoutOption).toInt());
+    QObject::connect(&benchmark, SIGNAL(finished()), &webAppManager, SLOT(quit()));
+
+    if (parser.isSet(childOption)) {
+        benchmark.run(fixtures.first(), 1);
+        webAppManager.exec();
+        QTextStream(stdout) << QJsonDocument(benchmark.runs()).toJson(QJsonDocument::Compact);
+        return 0;
+    }
+
+    QStringList childOptions;
+    childOptions << "--fixtures" << parser.value(fixturesOption)
+                 << "--timeout" << parser.value(timeoutOption);
+
+    QJsonObject report;
+    QTextStream out(stdout);
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+           .arg("fixture", -10).arg("mode", -6).arg("load[ms]", 10).arg("ready[ms]", 10)
+           .arg("frame[ms]", 10).arg("mgr[kB]", 10).arg("web[kB]", 10);
+
+    Q_FOREACH(const QString &fixture, fixtures) {
+        QJsonObject result;
+
+        if (mode == "cold" || mode == "both")
+            result.insert("cold", summarize(runCold(fixture, iterations, childOptions)));
+
+        if (mode == "warm" || mode == "both") {
+            // The first launch within the process is a cold one and dropped
+            benchmark.run(fixture, iterations + 1);
+            webAppManager.exec();
+
+            QJsonArray runs = benchmark.runs();
+            runs.removeFirst();
+            result.insert("warm", summarize(runs));
+        }
+
+        Q_FOREACH(const QString &key, result.keys()) {
+            QJsonObject summary = result.value(key).toObject();
+            out << QString("%1 %2 %3 %4 %5 %6 %7\n")
+                   .arg(fixture, -10).arg(key, -6)
+                   .arg(summary.value("loadSucceeded").toDouble(), 10, 'f', 1)
+                   .arg(summary.value("stageReady").toDouble(), 10, 'f', 1)
+                   .arg(summary.value("firstFrame").toDouble(), 10, 'f', 1)
+                   .arg(summary.value("peakManagerMemory").toDouble(), 10, 'f', 0)
+                   .arg(summary.value("peakWebProcessMemory").toDouble(), 10, 'f', 0);
+        }
+        out.flush();
+
+        report.insert(fixture, result);
+    }
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (file.open(QIODevice::WriteOnly))
+            file.write(QJsonDocument(report).toJson());
+    }
+
+    return 0;
+}
+
+#include "launchbenchmark.moc"
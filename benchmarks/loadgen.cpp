@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * Drives the manager's service methods through the in-process transport
+ * and reports throughput, latency percentiles and peak memory.
+ *
+ * Scenarios:
+ *   cards50              launch 50 card apps, query/relaunch them, kill them
+ *   bootstorm20headless  launch 20 headless apps at once, list them, kill them
+ */
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+
+#include <stdlib.h>
+
+#include "localservicetransport.h"
+#include "memoryusage.h"
+#include "webappmanager.h"
+
+using namespace luna;
+
+struct Operation
+{
+    QString method;
+    QByteArray payload;
+};
+
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+public:
+    LoadGenerator(LocalServiceTransport *transport, int concurrency, int rate) :
+        mTransport(transport),
+        mConcurrency(concurrency),
+        mOutstanding(0),
+        mCurrentPhase(0),
+        mNextOperation(0),
+        mDuration(0),
+        mPeakChildrenMemory(0)
+    {
+        mIssueTimer.setInterval(rate > 0 ? 1000 / rate : 0);
+        connect(&mIssueTimer, SIGNAL(timeout()), this, SLOT(onIssue()));
+
+        mSampleTimer.setInterval(100);
+        connect(&mSampleTimer, SIGNAL(timeout()), this, SLOT(onSampleMemory()));
+    }
+
+    void addPhase(const QList<Operation> &operations)
+    {
+        mPhases.append(operations);
+    }
+
+    void start()
+    {
+        mElapsed.start();
+        mSampleTimer.start();
+        mIssueTimer.start();
+    }
+
+    QJsonObject report() const
+    {
+        QJsonObject result;
+        int total = 0;
+
+        QJsonObject methods;
+        Q_FOREACH(const QString &method, mLatencies.keys()) {
+            QVector<qint64> latencies = mLatencies.value(method);
+            std::sort(latencies.begin(), latencies.end());
+            total += latencies.size();
+
+            QJsonObject stats;
+            stats.insert("calls", latencies.size());
+            stats.insert("p50", percentile(latencies, 50));
+            stats.insert("p90", percentile(latencies, 90));
+            stats.insert("p99", percentile(latencies, 99));
+            stats.insert("max", latencies.last() / 1000000.0);
+            methods.insert(method, stats);
+        }
+
+        double seconds = mDuration / 1000.0;
+
+        result.insert("calls", total);
+        result.insert("duration", seconds);
+        result.insert("throughput", seconds > 0 ? total / seconds : 0.0);
+        result.insert("methods", methods);
+        result.insert("peakManagerMemory", peakResidentMemory());
+        result.insert("peakWebProcessMemory", mPeakChildrenMemory);
+
+        return result;
+    }
+
+Q_SIGNALS:
+    void finished();
+
+private Q_SLOTS:
+    void onIssue()
+    {
+        // Phases without any calls (e.g. --queries 0) are done right away
+        advancePhase();
+
+        if (mCurrentPhase >= mPhases.size())
+            return;
+
+        const QList<Operation> &phase = mPhases.at(mCurrentPhase);
+
+        while (mNextOperation < phase.size() && mOutstanding < mConcurrency) {
+            issue(phase.at(mNextOperation++));
+
+            // With a rate limit only one call goes out per timer tick
+            if (mIssueTimer.interval() > 0)
+                break;
+        }
+    }
+
+    void onSampleMemory()
+    {
+        mPeakChildrenMemory = qMax(mPeakChildrenMemory, childrenResidentMemory());
+    }
+
+private:
+    void issue(const Operation &operation)
+    {
+        QElapsedTimer *timer = new QElapsedTimer;
+        timer->start();
+        mOutstanding++;
+
+        QString method = operation.method;
+        mTransport->call(method, operation.payload, [this, method, timer](const QByteArray &response) {
+            Q_UNUSED(response);
+            mLatencies[method].append(timer->nsecsElapsed());
+            delete timer;
+            onResponse();
+        });
+    }
+
+    void onResponse()
+    {
+        mOutstanding--;
+
+        advancePhase();
+    }
+
+    void advancePhase()
+    {
+        if (mCurrentPhase >= mPhases.size() && !mIssueTimer.isActive())
+            return;
+
+        // Phases act as barriers: the next one only starts once every call
+        // of the current one got its response
+        while (mCurrentPhase < mPhases.size() &&
+               mNextOperation >= mPhases.at(mCurrentPhase).size() && mOutstanding == 0) {
+            mCurrentPhase++;
+            mNextOperation = 0;
+        }
+
+        if (mCurrentPhase >= mPhases.size()) {
+            mDuration = mElapsed.elapsed();
+            mIssueTimer.stop();
+            onSampleMemory();
+            mSampleTimer.stop();
+            Q_EMIT finished();
+        }
+    }
+
+    static double percentile(const QVector<qint64> &sorted, int percent)
+    {
+        int index = qMin(sorted.size() - 1, (sorted.size() * percent) / 100);
+        return sorted.at(index) / 1000000.0;
+    }
+
+    LocalServiceTransport *mTransport;
+    int mConcurrency;
+    int mOutstanding;
+    QList<QList<Operation> > mPhases;
+    int mCurrentPhase;
+    int mNextOperation;
+    QTimer mIssueTimer;
+    QTimer mSampleTimer;
+    QElapsedTimer mElapsed;
+    qint64 mDuration;
+    qint64 mPeakChildrenMemory;
+    QMap<QString, QVector<qint64> > mLatencies;
+};
+
+static QString createStubApp(const QString &basePath, int n, bool headless, QJsonObject &desc)
+{
+    QString appId = QString("org.webosports.loadgen.app%1").arg(n);
+    QString appPath = QString("%1/%2").arg(basePath).arg(appId);
+
+    QDir().mkpath(appPath);
+
+    QFile index(appPath + "/index.html");
+    if (index.open(QIODevice::WriteOnly)) {
+        QTextStream stream(&index);
+        stream << "<!DOCTYPE html><html><head><title>" << appId << "</title></head>"
+               << "<body><p>" << appId << "</p></body></html>\n";
+    }
+
+    desc.insert("id", appId);
+    desc.insert("title", QString("Load %1").arg(n));
+    desc.insert("main", appPath + "/index.html");
+    desc.insert("noWindow", headless);
+
+    return appId;
+}
+
+static Operation createOperation(const QString &method, const QJsonObject &payload)
+{
+    Operation operation;
+    operation.method = method;
+    operation.payload = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+    return operation;
+}
+
+static Operation createAppIdOperation(const QString &method, const QString &appId)
+{
+    QJsonObject payload;
+    payload.insert("appId", appId);
+    return createOperation(method, payload);
+}
+
+int main(int argc, char **argv)
+{
+    // Nothing is shown to anyone so there's no need for a compositor
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+
+    QTemporaryDir storage;
+    setenv("XDG_DATA_HOME", QString("%1/data").arg(storage.path()).toUtf8().constData(), 0);
+    setenv("XDG_CACHE_HOME", QString("%1/cache").arg(storage.path()).toUtf8().constData(), 0);
+
+    LocalServiceTransport *transport = new LocalServiceTransport;
+    WebAppManager webAppManager(argc, argv, transport);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load generator for the web application manager service");
+    parser.addHelpOption();
+
+    QCommandLineOption scenarioOption("scenario", "Scenario to run: cards50 or bootstorm20headless", "name", "cards50");
+    QCommandLineOption appsOption("apps", "Number of stub applications", "count");
+    QCommandLineOption headlessOption("headless", "Launch the stub applications without a window");
+    QCommandLineOption concurrencyOption("concurrency", "Maximum number of outstanding calls", "count");
+    QCommandLineOption rateOption("rate", "Calls issued per second, 0 for no limit", "count", "0");
+    QCommandLineOption queriesOption("queries", "Query rounds per application", "count", "4");
+    QCommandLineOption outputOption("output", "Write the JSON report to a file", "path");
+
+    parser.addOption(scenarioOption);
+    parser.addOption(appsOption);
+    parser.addOption(headlessOption);
+    parser.addOption(concurrencyOption);
+    parser.addOption(rateOption);
+    parser.addOption(queriesOption);
+    parser.addOption(outputOption);
+    parser.process(webAppManager);
+
+    QString scenario = parser.value(scenarioOption);
+
+    int apps = 50;
+    int concurrency = 4;
+    bool headless = false;
+
+    if (scenario == "bootstorm20headless") {
+        apps = 20;
+        concurrency = 20;
+        headless = true;
+    }
+    else if (scenario != "cards50") {
+        qWarning("Unknown scenario %s", scenario.toUtf8().constData());
+        return 1;
+    }
+
+    if (parser.isSet(appsOption))
+        apps = qMax(0, parser.value(appsOption).toInt());
+    if (parser.isSet(concurrencyOption))
+        concurrency = qMax(1, parser.value(concurrencyOption).toInt());
+    if (parser.isSet(headlessOption))
+        headless = true;
+
+    int queries = qMax(0, parser.value(queriesOption).toInt());
+
+    LoadGenerator generator(transport, concurrency, parser.value(rateOption).toInt());
+
+    QStringList appIds;
+    QList<Operation> launches, queryCalls, kills;
+
+    for (int n = 0; n < apps; n++) {
+        QJsonObject desc;
+        QString appId = createStubApp(storage.path() + "/apps", n, headless, desc);
+        appIds.append(appId);
+
+        QJsonObject payload;
+        payload.insert("appDesc", desc);
+        payload.insert("params", QJsonObject());
+        payload.insert("processId", 1000 + n);
+        launches.append(createOperation("launchApp", payload));
+
+        kills.append(createAppIdOperation("killApp", appId));
+    }
+
+    for (int round = 0; round < queries; round++) {
+        Q_FOREACH(const QString &appId, appIds) {
+            queryCalls.append(createAppIdOperation("isAppRunning", appId));
+
+            QJsonObject payload;
+            payload.insert("appId", appId);
+            payload.insert("params", QString("{\"round\":%1}").arg(round));
+            queryCalls.append(createOperation("relaunch", payload));
+        }
+
+        queryCalls.append(createOperation("listRunningApps", QJsonObject()));
+    }
+
+    generator.addPhase(launches);
+    generator.addPhase(queryCalls);
+    generator.addPhase(kills);
+
+    QObject::connect(&generator, SIGNAL(finished()), &webAppManager, SLOT(quit()));
+
+    generator.start();
+    webAppManager.exec();
+
+    QJsonObject report = generator.report();
+    report.insert("scenario", scenario);
+    report.insert("apps", apps);
+    report.insert("concurrency", concurrency);
+    report.insert("headless", headless);
+
+    QByteArray output = QJsonDocument(report).toJson();
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (file.open(QIODevice::WriteOnly))
+            file.write(output);
+    }
+
+    QTextStream(stdout) << output;
+
+    return 0;
+}
+
+#include "loadgen.moc"
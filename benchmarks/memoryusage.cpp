@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QList>
+
+#include <unistd.h>
+
+#include "memoryusage.h"
+
+qint64 readStatusValue(const QString &path, const char *key)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    Q_FOREACH(const QByteArray &line, file.readAll().split('\n')) {
+        if (line.startsWith(key))
+            return line.mid(qstrlen(key) + 1).trimmed().split(' ').first().toLongLong();
+    }
+
+    return 0;
+}
+
+qint64 peakResidentMemory()
+{
+    return readStatusValue("/proc/self/status", "VmHWM:");
+}
+
+// Sums the resident memory of all direct children, which are the web
+// processes spawned for the applications
+qint64 childrenResidentMemory()
+{
+    qint64 total = 0;
+    QByteArray self = QByteArray::number(getpid());
+
+    Q_FOREACH(const QString &pid, QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile stat(QString("/proc/%1/stat").arg(pid));
+        if (!stat.open(QIODevice::ReadOnly))
+            continue;
+
+        // The command name may contain spaces so skip past it first
+        QByteArray data = stat.readAll();
+        QList<QByteArray> fields = data.mid(data.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() < 2 || fields.at(1) != self)
+            continue;
+
+        total += readStatusValue(QString("/proc/%1/status").arg(pid), "VmRSS:");
+    }
+
+    return total;
+}
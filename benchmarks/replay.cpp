@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * Re-issues service traffic recorded with --record-traffic against an
+ * in-process manager and compares the handler latencies with the recording.
+ *
+ * The replayed traffic is recorded again by the manager itself so both sides
+ * are measured the same way; the resulting log can be used as the reference
+ * for a later run. Exits with a non-zero status if the 90th percentile of
+ * any method got slower than the threshold, so it can be used as a
+ * regression test.
+ */
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QSharedPointer>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <QVector>
+
+#include <algorithm>
+
+#include <stdlib.h>
+
+#include "localservicetransport.h"
+#include "servicerecorder.h"
+#include "webappmanager.h"
+
+using namespace luna;
+
+class TrafficReplay : public QObject
+{
+    Q_OBJECT
+public:
+    TrafficReplay(LocalServiceTransport *transport, const QList<ServiceRecorder::Entry> &entries,
+                  double speed) :
+        mTransport(transport),
+        mEntries(entries),
+        mSpeed(speed),
+        mNext(0),
+        mOutstanding(0)
+    {
+        mTimer.setSingleShot(true);
+        connect(&mTimer, SIGNAL(timeout()), this, SLOT(onIssue()));
+    }
+
+    void start()
+    {
+        mElapsed.start();
+        scheduleNext();
+    }
+
+Q_SIGNALS:
+    void finished();
+
+private Q_SLOTS:
+    void onIssue()
+    {
+        qint64 now = mElapsed.nsecsElapsed() / 1000;
+
+        // Issue everything which is due, the timer resolution is coarser than
+        // the recorded arrival times
+        while (mNext < mEntries.size() && dueAt(mEntries.at(mNext)) <= now) {
+            const ServiceRecorder::Entry &entry = mEntries.at(mNext++);
+
+            // Subscriptions respond more than once but only the first
+            // response completes the call
+            QSharedPointer<bool> answered(new bool(false));
+
+            mOutstanding++;
+            mTransport->call(entry.method, entry.payload, [this, answered](const QByteArray &response) {
+                Q_UNUSED(response);
+                if (*answered)
+                    return;
+                *answered = true;
+                onResponse();
+            }, entry.subscription);
+        }
+
+        scheduleNext();
+    }
+
+private:
+    qint64 dueAt(const ServiceRecorder::Entry &entry) const
+    {
+        return mSpeed > 0 ? static_cast<qint64>(entry.arrival / mSpeed) : 0;
+    }
+
+    void scheduleNext()
+    {
+        if (mNext >= mEntries.size())
+            return;
+
+        qint64 delay = dueAt(mEntries.at(mNext)) - mElapsed.nsecsElapsed() / 1000;
+        mTimer.start(qMax<qint64>(0, delay / 1000));
+    }
+
+    void onResponse()
+    {
+        mOutstanding--;
+
+        if (mNext >= mEntries.size() && mOutstanding == 0)
+            QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+    }
+
+    LocalServiceTransport *mTransport;
+    QList<ServiceRecorder::Entry> mEntries;
+    double mSpeed;
+    int mNext;
+    int mOutstanding;
+    QTimer mTimer;
+    QElapsedTimer mElapsed;
+};
+
+static qint64 percentile(QVector<qint64> values, int percent)
+{
+    if (values.isEmpty())
+        return 0;
+
+    std::sort(values.begin(), values.end());
+    return values.at(qMin(values.size() - 1, (values.size() * percent) / 100));
+}
+
+static QMap<QString, QVector<qint64> > latenciesByMethod(const QList<ServiceRecorder::Entry> &entries)
+{
+    QMap<QString, QVector<qint64> > latencies;
+    Q_FOREACH(const ServiceRecorder::Entry &entry, entries)
+        latencies[entry.method].append(entry.latency);
+    return latencies;
+}
+
+int main(int argc, char **argv)
+{
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+
+    QTemporaryDir storage;
+    setenv("XDG_DATA_HOME", QString("%1/data").arg(storage.path()).toUtf8().constData(), 0);
+    setenv("XDG_CACHE_HOME", QString("%1/cache").arg(storage.path()).toUtf8().constData(), 0);
+
+    LocalServiceTransport *transport = new LocalServiceTransport;
+    WebAppManager webAppManager(argc, argv, transport);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replays recorded service traffic against the web application manager");
+    parser.addHelpOption();
+    parser.addPositionalArgument("log", "Traffic log recorded with --record-traffic");
+
+    QCommandLineOption speedOption("speed", "Speed factor, 0 issues everything at once", "factor", "1");
+    QCommandLineOption outputOption("output", "Where to record the replayed traffic", "path");
+    QCommandLineOption thresholdOption("threshold", "Allowed p90 slowdown per method in percent", "percent", "20");
+
+    parser.addOption(speedOption);
+    parser.addOption(outputOption);
+    parser.addOption(thresholdOption);
+    parser.process(webAppManager);
+
+    if (parser.positionalArguments().isEmpty())
+        parser.showHelp(1);
+
+    QList<ServiceRecorder::Entry> original = ServiceRecorder::readLog(parser.positionalArguments().first());
+    if (original.isEmpty()) {
+        qWarning("No requests found in %s", parser.positionalArguments().first().toUtf8().constData());
+        return 1;
+    }
+
+    QString output = parser.value(outputOption);
+    if (output.isEmpty())
+        output = storage.path() + "/replay.log";
+
+    webAppManager.setTrafficRecordFile(output);
+
+    TrafficReplay replay(transport, original, parser.value(speedOption).toDouble());
+    QObject::connect(&replay, SIGNAL(finished()), &webAppManager, SLOT(quit()));
+
+    replay.start();
+    webAppManager.exec();
+
+    webAppManager.setTrafficRecordFile(QString());
+
+    QMap<QString, QVector<qint64> > before = latenciesByMethod(original);
+    QMap<QString, QVector<qint64> > after = latenciesByMethod(ServiceRecorder::readLog(output));
+
+    double threshold = parser.value(thresholdOption).toDouble();
+    int regressions = 0;
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5 %6\n").arg("method", -24).arg("calls", 6)
+           .arg("p50[us]", 16).arg("p90[us]", 16).arg("change", 8).arg("");
+
+    Q_FOREACH(const QString &method, before.keys()) {
+        qint64 p50Before = percentile(before.value(method), 50);
+        qint64 p90Before = percentile(before.value(method), 90);
+        qint64 p50After = percentile(after.value(method), 50);
+        qint64 p90After = percentile(after.value(method), 90);
+
+        double change = p90Before > 0 ? (p90After - p90Before) * 100.0 / p90Before : 0.0;
+        bool regression = change > threshold;
+        if (regression)
+            regressions++;
+
+        out << QString("%1 %2 %3 %4 %5 %6\n").arg(method, -24)
+               .arg(after.value(method).size(), 6)
+               .arg(QString("%1 -> %2").arg(p50Before).arg(p50After), 16)
+               .arg(QString("%1 -> %2").arg(p90Before).arg(p90After), 16)
+               .arg(QString("%1%").arg(change, 0, 'f', 1), 8)
+               .arg(regression ? "REGRESSION" : "");
+    }
+
+    return regressions > 0 ? 1 : 0;
+}
+
+#include "replay.moc"
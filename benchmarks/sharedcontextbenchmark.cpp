@@ -0,0 +1,279 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * Opens a number of windows of the minimal fixture at once and compares the
+ * memory use of the manager with and without OpenGL context sharing. Each
+ * mode runs in its own process as sharing has to be decided before the
+ * application is created.
+ *
+ * Rendering happens on the offscreen platform with Mesa's software
+ * rasterizer, so the GL resources show up in the resident memory of the
+ * process. With -platform xcb the benchmark runs against a (virtual) X
+ * server instead.
+ */
+
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "localservicetransport.h"
+#include "memoryusage.h"
+#include "utils.h"
+#include "webappmanager.h"
+#include "webapplication.h"
+#include "webapplicationwindow.h"
+
+using namespace luna;
+
+#define SETTLE_DELAY    1000
+
+class WindowsBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    WindowsBenchmark(WebAppManager *manager, LocalServiceTransport *transport,
+                     const QString &entryPoint, int windows, int timeout) :
+        mManager(manager),
+        mTransport(transport),
+        mEntryPoint(entryPoint),
+        mWindows(windows),
+        mFramesSwapped(0),
+        mLaunched(0)
+    {
+        mTimeoutTimer.setSingleShot(true);
+        mTimeoutTimer.setInterval(timeout);
+        connect(&mTimeoutTimer, SIGNAL(timeout()), this, SLOT(onSettle()));
+    }
+
+    QJsonObject result() const
+    {
+        return mResult;
+    }
+
+Q_SIGNALS:
+    void finished();
+
+public Q_SLOTS:
+    void run()
+    {
+        mTimeoutTimer.start();
+
+        for (int n = 0; n < mWindows; n++) {
+            QString appId = QString("org.webosports.benchmark.window%1").arg(n);
+
+            QJsonObject desc;
+            desc.insert("id", appId);
+            desc.insert("title", appId);
+            desc.insert("main", mEntryPoint);
+
+            QJsonObject payload;
+            payload.insert("appDesc", desc);
+            payload.insert("params", QJsonObject());
+            payload.insert("processId", 1000 + n);
+
+            mTransport->call("launchApp", QJsonDocument(payload).toJson(QJsonDocument::Compact),
+                             [this, appId](const QByteArray &response) {
+                Q_UNUSED(response);
+                onLaunchResponse(appId);
+            });
+        }
+    }
+
+private Q_SLOTS:
+    void onApplicationLaunched()
+    {
+        WebApplication *application = static_cast<WebApplication*>(sender());
+        connect(application->mainWindow(), SIGNAL(firstFrameSwapped()), this, SLOT(onFirstFrameSwapped()));
+        mLaunched++;
+    }
+
+    void onFirstFrameSwapped()
+    {
+        if (++mFramesSwapped < mWindows)
+            return;
+
+        mTimeoutTimer.stop();
+        onSettle();
+    }
+
+    void onSettle()
+    {
+        // Give the render threads some time to finish up before measuring
+        QTimer::singleShot(SETTLE_DELAY, this, SLOT(onMeasure()));
+    }
+
+    void onMeasure()
+    {
+        mResult.insert("windows", mLaunched);
+        mResult.insert("framesSwapped", mFramesSwapped);
+        mResult.insert("residentMemory", residentMemory(getpid()));
+        mResult.insert("peakResidentMemory", peakResidentMemory());
+
+        Q_EMIT finished();
+    }
+
+private:
+    void onLaunchResponse(const QString &appId)
+    {
+        Q_FOREACH(WebApplication *app, mManager->applications()) {
+            if (app->id() == appId)
+                connect(app, SIGNAL(launched()), this, SLOT(onApplicationLaunched()));
+        }
+    }
+
+    WebAppManager *mManager;
+    LocalServiceTransport *mTransport;
+    QString mEntryPoint;
+    int mWindows;
+    int mFramesSwapped;
+    int mLaunched;
+    QTimer mTimeoutTimer;
+    QJsonObject mResult;
+};
+
+static QJsonObject runMode(bool share, const QStringList &options)
+{
+    QProcess process;
+    process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+
+    QStringList arguments = options;
+    arguments << "--child";
+    if (share)
+        arguments << "--share";
+
+    process.start(QCoreApplication::applicationFilePath(), arguments);
+
+    if (!process.waitForFinished(120000)) {
+        process.kill();
+        qWarning("Run %s context sharing timed out", share ? "with" : "without");
+        return QJsonObject();
+    }
+
+    return QJsonDocument::fromJson(process.readAllStandardOutput()).object();
+}
+
+int main(int argc, char **argv)
+{
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+    setenv("LIBGL_ALWAYS_SOFTWARE", "1", 0);
+
+    // Sharing can only be enabled before the application exists
+    for (int n = 1; n < argc; n++) {
+        if (strcmp(argv[n], "--share") == 0)
+            QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
+    }
+
+    QTemporaryDir storage;
+    setenv("XDG_DATA_HOME", QString("%1/data").arg(storage.path()).toUtf8().constData(), 0);
+    setenv("XDG_CACHE_HOME", QString("%1/cache").arg(storage.path()).toUtf8().constData(), 0);
+
+    LocalServiceTransport *transport = new LocalServiceTransport;
+    WebAppManager webAppManager(argc, argv, transport);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Memory use of many windows with and without shared OpenGL contexts");
+    parser.addHelpOption();
+
+    QCommandLineOption windowsOption("windows", "Number of windows to open", "count", "12");
+    QCommandLineOption fixturesOption("fixtures", "Directory containing the fixture applications", "path", FIXTURES_DIR);
+    QCommandLineOption timeoutOption("timeout", "Time to wait for all windows to render in ms", "ms", "60000");
+    QCommandLineOption outputOption("output", "Write the JSON report to a file", "path");
+    QCommandLineOption childOption("child", "Internal: run a single mode");
+    QCommandLineOption shareOption("share", "Internal: enable context sharing");
+
+    parser.addOption(windowsOption);
+    parser.addOption(fixturesOption);
+    parser.addOption(timeoutOption);
+    parser.addOption(outputOption);
+    parser.addOption(childOption);
+    parser.addOption(shareOption);
+    parser.process(webAppManager);
+
+    if (parser.isSet(childOption)) {
+        WindowsBenchmark benchmark(&webAppManager, transport,
+                                   parser.value(fixturesOption) + "/minimal/index.html",
+                                   qMax(1, parser.value(windowsOption).toInt()),
+                                   parser.value(timeoutOption).toInt());
+        QObject::connect(&benchmark, SIGNAL(finished()), &webAppManager, SLOT(quit()));
+        QMetaObject::invokeMethod(&benchmark, "run", Qt::QueuedConnection);
+        webAppManager.exec();
+
+        QTextStream(stdout) << QJsonDocument(benchmark.result()).toJson(QJsonDocument::Compact);
+        return 0;
+    }
+
+    QStringList childOptions;
+    childOptions << "--windows" << parser.value(windowsOption)
+                 << "--fixtures" << parser.value(fixturesOption)
+                 << "--timeout" << parser.value(timeoutOption);
+
+    QJsonObject report;
+    report.insert("separate", runMode(false, childOptions));
+    report.insert("shared", runMode(true, childOptions));
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5\n")
+           .arg("mode", -10).arg("windows", 8).arg("frames", 8).arg("rss[kB]", 10).arg("peak[kB]", 10);
+
+    Q_FOREACH(const QString &mode, QStringList() << "separate" << "shared") {
+        QJsonObject result = report.value(mode).toObject();
+        out << QString("%1 %2 %3 %4 %5\n")
+               .arg(mode, -10)
+               .arg(result.value("windows").toInt(), 8)
+               .arg(result.value("framesSwapped").toInt(), 8)
+               .arg(result.value("residentMemory").toDouble(), 10, 'f', 0)
+               .arg(result.value("peakResidentMemory").toDouble(), 10, 'f', 0);
+    }
+
+    // Windows which never rendered didn't allocate their GL resources, so
+    // comparing such runs would report savings which don't exist
+    bool complete = true;
+    Q_FOREACH(const QString &mode, QStringList() << "separate" << "shared") {
+        QJsonObject result = report.value(mode).toObject();
+        if (result.value("framesSwapped").toInt() < result.value("windows").toInt()) {
+            qWarning("Not all windows rendered when running %s, not comparing memory use",
+                     mode.toUtf8().constData());
+            complete = false;
+        }
+    }
+
+    double separate = report.value("separate").toObject().value("residentMemory").toDouble();
+    double shared = report.value("shared").toObject().value("residentMemory").toDouble();
+    int windows = report.value("shared").toObject().value("windows").toInt();
+    if (complete && windows > 0)
+        out << QString("saving per window: %1 kB\n").arg((separate - shared) / windows, 0, 'f', 0);
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (file.open(QIODevice::WriteOnly))
+            file.write(QJsonDocument(report).toJson());
+    }
+
+    return complete ? 0 : 1;
+}
+
+#include "sharedcontextbenchmark.moc"
@@ -0,0 +1,464 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTemporaryDir>
+#include <QVector>
+
+#include <stdlib.h>
+
+#include <networkservice.h>
+
+#include <applicationenvironment.h>
+#include <baseextension.h>
+
+#include "applicationdescription.h"
+#include "localservicetransport.h"
+#include "resourcepathvalidator.h"
+#include "utils.h"
+#include "webappmanager.h"
+#include "extensions/palmsystemextension.h"
+#include "extensions/wifimanager.h"
+
+using namespace luna;
+
+static LocalServiceTransport *sTransport = 0;
+
+class NullEnvironment : public ApplicationEnvironment
+{
+public:
+    NullEnvironment() : mScriptLength(0) { }
+
+    void executeScript(const QString &script) { mScriptLength += script.length(); }
+    void registerUserScript(const QUrl &path) { Q_UNUSED(path); }
+
+    int mScriptLength;
+};
+
+class CallbackExtension : public BaseExtension
+{
+public:
+    CallbackExtension(ApplicationEnvironment *environment) :
+        BaseExtension("Callback", environment)
+    {
+    }
+
+    void fire(int id, const QString &parameters)
+    {
+        callback(id, parameters);
+    }
+
+    QString handleSynchronousCall(const QString &funcName, const QJsonArray &params)
+    {
+        Q_UNUSED(params);
+        return funcName;
+    }
+};
+
+static QString createAppDescription(int urlsAllowed)
+{
+    QJsonObject desc;
+    desc.insert("id", QString("org.webosports.app.benchmark"));
+    desc.insert("title", QString("Benchmark"));
+    desc.insert("main", QString("/usr/palm/applications/org.webosports.app.benchmark/index.html"));
+    desc.insert("icon", QString("/usr/palm/applications/org.webosports.app.benchmark/icon.png"));
+    desc.insert("noWindow", false);
+    desc.insert("flickable", true);
+    desc.insert("internetConnectivityRequired", false);
+    desc.insert("userAgent", QString("Mozilla/5.0 (Linux; webOS/3.5)"));
+
+    QJsonArray urls;
+    for (int n = 0; n < urlsAllowed; n++)
+        urls.append(QString("https://%1.example.org/*").arg(n));
+    desc.insert("urlsAllowed", urls);
+
+    return jsonObjectToString(desc);
+}
+
+static QJsonObject createRoundTripDescription(const QString &appId)
+{
+    QJsonObject desc;
+    desc.insert("id", appId);
+    desc.insert("title", QString("Benchmark"));
+    desc.insert("main", QString(FIXTURES_DIR "/minimal/index.html"));
+
+    // Applications kept around for the queries shouldn't load anything
+    // while we measure
+    desc.insert("launchHidden", true);
+    desc.insert("hiddenLaunchMode", QString("defer"));
+
+    return desc;
+}
+
+// Calls the method through the transport and waits for the first response
+static QJsonObject callAndWait(const QString &method, const QJsonObject &request)
+{
+    bool responded = false;
+    QJsonObject result;
+    sTransport->call(method, QJsonDocument(request).toJson(QJsonDocument::Compact),
+                     [&](const QByteArray &response) {
+        if (responded)
+            return;
+        responded = true;
+        result = QJsonDocument::fromJson(response).object();
+    });
+
+    while (!responded)
+        QCoreApplication::processEvents();
+
+    return result;
+}
+
+static QVariantMap createSyncMessage(int paramCount)
+{
+    QJsonArray params;
+    for (int n = 0; n < paramCount; n++)
+        params.append(QString("param%1").arg(n));
+
+    QJsonObject call;
+    call.insert("messageType", QString("callSyncExtensionFunction"));
+    call.insert("extension", QString("PalmSystem"));
+    call.insert("func", QString("getProperty"));
+    call.insert("params", params);
+
+    QVariantMap message;
+    message.insert("data", jsonObjectToString(call));
+    return message;
+}
+
+class WebAppManagerBenchmark : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void cleanupTestCase();
+
+    void applicationDescriptionParse_data();
+    void applicationDescriptionParse();
+
+    void resourcePathValidate_data();
+    void resourcePathValidate();
+
+    void syncMessageDispatch_data();
+    void syncMessageDispatch();
+
+    void palmSystemPropertyLookup_data();
+    void palmSystemPropertyLookup();
+
+    void extensionCallback_data();
+    void extensionCallback();
+
+    void networksResponse_data();
+    void networksResponse();
+
+    void launchAppRoundTrip();
+
+    void serviceRoundTrip_data();
+    void serviceRoundTrip();
+
+private:
+    QVector<NetworkService*> mNetworks;
+};
+
+void WebAppManagerBenchmark::cleanupTestCase()
+{
+    qDeleteAll(mNetworks);
+    mNetworks.clear();
+}
+
+void WebAppManagerBenchmark::applicationDescriptionParse_data()
+{
+    QTest::addColumn<int>("urlsAllowed");
+
+    QTest::newRow("plain") << 0;
+    QTest::newRow("urls16") << 16;
+}
+
+void WebAppManagerBenchmark::applicationDescriptionParse()
+{
+    QFETCH(int, urlsAllowed);
+
+    QString data = createAppDescription(urlsAllowed);
+
+    QBENCHMARK {
+        ApplicationDescription desc(data);
+        Q_UNUSED(desc);
+    }
+}
+
+void WebAppManagerBenchmark::resourcePathValidate_data()
+{
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<bool>("privileged");
+
+    QTest::newRow("allowed-privileged") << QString("/usr/palm/applications/org.webosports.app.memos/index.html") << true;
+    QTest::newRow("allowed-unprivileged") << QString("/media/cryptofs/apps/usr/palm/applications/com.example.app/index.html") << false;
+    QTest::newRow("denied") << QString("/etc/shadow") << false;
+}
+
+void WebAppManagerBenchmark::resourcePathValidate()
+{
+    QFETCH(QString, path);
+    QFETCH(bool, privileged);
+
+    ResourcePathValidator &validator = ResourcePathValidator::instance();
+
+    QBENCHMARK {
+        validator.validate(path, privileged);
+    }
+}
+
+void WebAppManagerBenchmark::syncMessageDispatch_data()
+{
+    QTest::addColumn<int>("paramCount");
+
+    QTest::newRow("params1") << 1;
+    QTest::newRow("params8") << 8;
+}
+
+void WebAppManagerBenchmark::syncMessageDispatch()
+{
+    QFETCH(int, paramCount);
+
+    NullEnvironment environment;
+    QMap<QString, BaseExtension*> extensions;
+    extensions.insert("Callback", new CallbackExtension(&environment));
+    extensions.insert("PalmSystem", new CallbackExtension(&environment));
+    extensions.insert("WiFiManager", new CallbackExtension(&environment));
+
+    QVariantMap message = createSyncMessage(paramCount);
+
+    QBENCHMARK {
+        QString extensionName, func;
+        QJsonArray params;
+
+        if (!parseSyncExtensionCall(message, extensionName, func, params))
+            QFAIL("Failed to parse sync message");
+
+        BaseExtension *extension = extensions.value(extensionName);
+        if (!extension)
+            QFAIL("Failed to find extension");
+
+        extension->handleSynchronousCall(func, params);
+    }
+
+    qDeleteAll(extensions);
+}
+
+void WebAppManagerBenchmark::palmSystemPropertyLookup_data()
+{
+    QTest::addColumn<QString>("name");
+
+    QTest::newRow("first") << QString("launchParams");
+    QTest::newRow("last") << QString("version");
+    QTest::newRow("unknown") << QString("doesNotExist");
+}
+
+void WebAppManagerBenchmark::palmSystemPropertyLookup()
+{
+    QFETCH(QString, name);
+
+    QBENCHMARK {
+        PalmSystemExtension::lookupProperty(name);
+    }
+}
+
+void WebAppManagerBenchmark::extensionCallback_data()
+{
+    QTest::addColumn<QString>("parameters");
+
+    QTest::newRow("empty") << QString();
+    QTest::newRow("object") << QString("{\"returnValue\":true,\"networks\":[]}");
+}
+
+void WebAppManagerBenchmark::extensionCallback()
+{
+    QFETCH(QString, parameters);
+
+    NullEnvironment environment;
+    CallbackExtension extension(&environment);
+
+    QBENCHMARK {
+        extension.fire(42, parameters);
+    }
+}
+
+void WebAppManagerBenchmark::networksResponse_data()
+{
+    QTest::addColumn<int>("count");
+
+    QTest::newRow("networks1") << 1;
+    QTest::newRow("networks32") << 32;
+}
+
+void WebAppManagerBenchmark::networksResponse()
+{
+    QFETCH(int, count);
+
+    while (mNetworks.size() < count) {
+        int n = mNetworks.size();
+
+        QVariantMap properties;
+        properties.insert("Name", QString("network%1").arg(n));
+        properties.insert("State", QString("idle"));
+        properties.insert("Security", QStringList() << "psk");
+        properties.insert("Strength", QVariant::fromValue<uchar>(n % 100));
+        properties.insert("Favorite", false);
+        properties.insert("AutoConnect", false);
+        properties.insert("Roaming", false);
+
+        mNetworks.append(new NetworkService(QString("/net/connman/service/wifi_%1").arg(n), properties));
+    }
+
+    QVector<NetworkService*> networks = mNetworks.mid(0, count);
+
+    QBENCHMARK {
+        WiFiManager::createNetworksResponse(networks);
+    }
+}
+
+void WebAppManagerBenchmark::launchAppRoundTrip()
+{
+    WebAppManager *manager = static_cast<WebAppManager*>(QCoreApplication::instance());
+    int processId = 1000;
+
+    // Goes through the transport, WebAppManagerService::launchApp and
+    // WebAppManager::launchApp up to the launch being scheduled. The launch
+    // is cancelled again right away so the applications don't pile up.
+    QBENCHMARK {
+        QString appId = QString("org.webosports.benchmark.roundtrip%1").arg(processId);
+
+        QJsonObject desc;
+        desc.insert("id", appId);
+        desc.insert("title", QString("Benchmark"));
+        desc.insert("main", QString(FIXTURES_DIR "/minimal/index.html"));
+
+        QJsonObject request;
+        request.insert("appDesc", desc);
+        request.insert("params", QJsonObject());
+        request.insert("processId", processId++);
+
+        bool responded = false;
+        bool launched = false;
+        sTransport->call("launchApp", QJsonDocument(request).toJson(QJsonDocument::Compact),
+                         [&](const QByteArray &response) {
+            responded = true;
+            launched = QJsonDocument::fromJson(response).object().value("returnValue").toBool();
+            manager->killApp(appId);
+        });
+
+        while (!responded)
+            QCoreApplication::processEvents();
+
+        if (!launched)
+            QFAIL("launchApp failed");
+    }
+
+    // Let the closed applications go
+    QCoreApplication::processEvents();
+}
+
+void WebAppManagerBenchmark::serviceRoundTrip_data()
+{
+    QTest::addColumn<QString>("method");
+    QTest::addColumn<int>("runningApps");
+
+    QTest::newRow("launchUrl") << QString("launchUrl") << 1;
+    QTest::newRow("killApp") << QString("killApp") << 1;
+    QTest::newRow("isAppRunning-apps1") << QString("isAppRunning") << 1;
+    QTest::newRow("isAppRunning-apps16") << QString("isAppRunning") << 16;
+    QTest::newRow("listRunningApps-apps1") << QString("listRunningApps") << 1;
+    QTest::newRow("listRunningApps-apps16") << QString("listRunningApps") << 16;
+}
+
+void WebAppManagerBenchmark::serviceRoundTrip()
+{
+    QFETCH(QString, method);
+    QFETCH(int, runningApps);
+
+    WebAppManager *manager = static_cast<WebAppManager*>(QCoreApplication::instance());
+    int processId = 2000;
+
+    // The queries answer from the running applications, so have some
+    QStringList running;
+    for (int n = 0; n < runningApps; n++) {
+        QString appId = QString("org.webosports.benchmark.running%1").arg(n);
+        QString desc = jsonObjectToString(createRoundTripDescription(appId));
+        if (!manager->launchApp(desc, "{}", processId++))
+            QFAIL("Failed to launch the running applications");
+        running.append(appId);
+    }
+
+    QBENCHMARK {
+        QJsonObject request;
+
+        if (method == "launchUrl") {
+            // Launched and cancelled again like in launchAppRoundTrip
+            QString appId = QString("org.webosports.benchmark.url%1").arg(processId);
+            request.insert("url", QString("file://" FIXTURES_DIR "/minimal/index.html"));
+            request.insert("appDesc", createRoundTripDescription(appId));
+            request.insert("processId", processId++);
+
+            QJsonObject response = callAndWait(method, request);
+            manager->killApp(appId);
+
+            if (!response.value("returnValue").toBool())
+                QFAIL("launchUrl failed");
+        }
+        else if (method == "killApp") {
+            // Looking up an application which isn't running, so there is
+            // always something to kill
+            request.insert("appId", QString("org.webosports.benchmark.notrunning"));
+            callAndWait(method, request);
+        }
+        else if (method == "isAppRunning") {
+            request.insert("appId", running.last());
+            if (!callAndWait(method, request).value("running").toBool())
+                QFAIL("isAppRunning didn't find the running application");
+        }
+        else {
+            callAndWait(method, request);
+        }
+    }
+
+    Q_FOREACH(const QString &appId, running)
+        manager->killApp(appId);
+
+    // Let the closed applications go
+    QCoreApplication::processEvents();
+}
+
+int main(int argc, char **argv)
+{
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+
+    QTemporaryDir storage;
+    setenv("XDG_DATA_HOME", QString("%1/data").arg(storage.path()).toUtf8().constData(), 0);
+    setenv("XDG_CACHE_HOME", QString("%1/cache").arg(storage.path()).toUtf8().constData(), 0);
+
+    // The round trip benchmark needs the real manager behind the transport
+    sTransport = new LocalServiceTransport;
+    WebAppManager webAppManager(argc, argv, sTransport);
+
+    WebAppManagerBenchmark benchmark;
+    return QTest::qExec(&benchmark, argc, argv);
+}
+
+#include "webappmanagerbenchmark.moc"
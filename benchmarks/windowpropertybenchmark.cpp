@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+/*
+ * Creates a number of windows and sets the properties every window of the
+ * manager gets, once one by one through the platform native interface like
+ * the manager used to and once staged and flushed with WindowProperties.
+ * After the properties of a window are out a wl_display_roundtrip measures
+ * how long it takes until the compositor processed all of them. Setting all
+ * properties a second time shows what the unchanged values cost.
+ *
+ * Needs a running Wayland compositor, for example
+ *
+ *   weston --backend=headless-backend.so --socket=wayland-bench &
+ *   WAYLAND_DISPLAY=wayland-bench windowpropertybenchmark
+ *
+ * Only compositors offering the extended surface interface (like luna-next)
+ * actually receive the properties, with others just the client side is
+ * measured.
+ */
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QWindow>
+
+#include <QtGui/qpa/qplatformnativeinterface.h>
+
+#include <stdlib.h>
+
+#include <wayland-client.h>
+
+#include "windowproperties.h"
+
+using namespace luna;
+
+static const char *propertyNames[] = {
+    "_LUNE_WINDOW_TYPE",
+    "_LUNE_WINDOW_PARENT_ID",
+    "_LUNE_WINDOW_LOADING_ANIMATION_DISABLED",
+    "_LUNE_APP_ICON",
+    "_LUNE_APP_ID",
+    0
+};
+
+static QVariant propertyValue(const char *name, int window)
+{
+    QString property(name);
+
+    if (property == "_LUNE_WINDOW_TYPE")
+        return QVariant(QString("card"));
+    else if (property == "_LUNE_WINDOW_PARENT_ID")
+        return QVariant(0);
+    else if (property == "_LUNE_WINDOW_LOADING_ANIMATION_DISABLED")
+        return QVariant(false);
+    else if (property == "_LUNE_APP_ICON")
+        return QVariant(QString("/usr/palm/applications/benchmark/icon.png"));
+
+    return QVariant(QString("org.webosports.benchmark.window%1").arg(window));
+}
+
+class Measurement
+{
+public:
+    Measurement() :
+        mSetupTime(0),
+        mRoundtripTime(0),
+        mRequests(0)
+    {
+    }
+
+    void addSetup(qint64 nsecs) { mSetupTime += nsecs; }
+    void addRoundtrip(qint64 nsecs) { mRoundtripTime += nsecs; }
+    void addRequests(int count) { mRequests += count; }
+
+    QJsonObject toJson(int windows) const
+    {
+        QJsonObject result;
+        result.insert("setupTime", mSetupTime / 1000000.0 / windows);
+        result.insert("roundtripTime", mRoundtripTime / 1000000.0 / windows);
+        result.insert("requests", mRequests);
+        return result;
+    }
+
+private:
+    qint64 mSetupTime;
+    qint64 mRoundtripTime;
+    int mRequests;
+};
+
+static struct wl_display* waylandDisplay()
+{
+    QPlatformNativeInterface *nativeInterface = QGuiApplication::platformNativeInterface();
+    if (!nativeInterface)
+        return 0;
+
+    return static_cast<struct wl_display*>(nativeInterface->nativeResourceForIntegration("wl_display"));
+}
+
+static qint64 roundtrip(struct wl_display *display)
+{
+    QElapsedTimer timer;
+    timer.start();
+    wl_display_roundtrip(display);
+    return timer.nsecsElapsed();
+}
+
+static QJsonObject runDirect(struct wl_display *display, int windows)
+{
+    QPlatformNativeInterface *nativeInterface = QGuiApplication::platformNativeInterface();
+    Measurement initial, repeated;
+    QList<QWindow*> created;
+
+    for (int n = 0; n < windows; n++) {
+        QWindow *window = new QWindow;
+        created.append(window);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        window->create();
+        for (int i = 0; propertyNames[i]; i++)
+            nativeInterface->setWindowProperty(window->handle(), propertyNames[i], propertyValue(propertyNames[i], n));
+
+        initial.addSetup(timer.nsecsElapsed());
+        initial.addRoundtrip(roundtrip(display));
+        initial.addRequests(5);
+
+        timer.restart();
+        for (int i = 0; propertyNames[i]; i++)
+            nativeInterface->setWindowProperty(window->handle(), propertyNames[i], propertyValue(propertyNames[i], n));
+
+        repeated.addSetup(timer.nsecsElapsed());
+        repeated.addRoundtrip(roundtrip(display));
+        repeated.addRequests(5);
+    }
+
+    qDeleteAll(created);
+
+    QJsonObject result;
+    result.insert("initial", initial.toJson(windows));
+    result.insert("repeated", repeated.toJson(windows));
+    return result;
+}
+
+static QJsonObject runStaged(struct wl_display *display, int windows)
+{
+    Measurement initial, repeated;
+    QList<QWindow*> created;
+
+    for (int n = 0; n < windows; n++) {
+        QWindow *window = new QWindow;
+        created.append(window);
+
+        WindowProperties properties(window);
+
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int i = 0; propertyNames[i]; i++)
+            properties.setProperty(propertyNames[i], propertyValue(propertyNames[i], n));
+        window->create();
+        properties.flush();
+
+        initial.addSetup(timer.nsecsElapsed());
+        initial.addRoundtrip(roundtrip(display));
+        initial.addRequests(properties.sentCount());
+
+        int sent = properties.sentCount();
+
+        timer.restart();
+        for (int i = 0; propertyNames[i]; i++)
+            properties.setProperty(propertyNames[i], propertyValue(propertyNames[i], n));
+
+        repeated.addSetup(timer.nsecsElapsed());
+        repeated.addRoundtrip(roundtrip(display));
+        repeated.addRequests(properties.sentCount() - sent);
+    }
+
+    qDeleteAll(created);
+
+    QJsonObject result;
+    result.insert("initial", initial.toJson(windows));
+    result.insert("repeated", repeated.toJson(windows));
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    setenv("QT_QPA_PLATFORM", "wayland", 1);
+
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Cost of setting up window properties against a Wayland compositor");
+    parser.addHelpOption();
+
+    QCommandLineOption windowsOption("windows", "Number of windows to create per mode", "count", "50");
+    QCommandLineOption outputOption("output", "Write the JSON report to a file", "path");
+
+    parser.addOption(windowsOption);
+    parser.addOption(outputOption);
+    parser.process(app);
+
+    struct wl_display *display = waylandDisplay();
+    if (!display) {
+        qWarning("Not connected to a Wayland compositor");
+        return 1;
+    }
+
+    int windows = qMax(1, parser.value(windowsOption).toInt());
+
+    // Let the connection settle so the first window isn't charged for it
+    wl_display_roundtrip(display);
+
+    QJsonObject report;
+    report.insert("windows", windows);
+    report.insert("direct", runDirect(display, windows));
+    report.insert("staged", runStaged(display, windows));
+
+    QTextStream out(stdout);
+    out << QString("%1 %2 %3 %4 %5\n")
+           .arg("mode", -10).arg("phase", -10).arg("setup[ms]", 10).arg("rtt[ms]", 10).arg("requests", 10);
+
+    Q_FOREACH(const QString &mode, QStringList() << "direct" << "staged") {
+        Q_FOREACH(const QString &phase, QStringList() << "initial" << "repeated") {
+            QJsonObject result = report.value(mode).toObject().value(phase).toObject();
+            out << QString("%1 %2 %3 %4 %5\n")
+                   .arg(mode, -10)
+                   .arg(phase, -10)
+                   .arg(result.value("setupTime").toDouble(), 10, 'f', 3)
+                   .arg(result.value("roundtripTime").toDouble(), 10, 'f', 3)
+                   .arg(result.value("requests").toInt(), 10);
+        }
+    }
+
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (file.open(QIODevice::WriteOnly))
+            file.write(QJsonDocument(report).toJson());
+    }
+
+    return 0;
+}
@@ -21,6 +21,7 @@
 #include <glib.h>
 
 #include "activity.h"
+#include "logging.h"
 
 namespace luna
 {
@@ -34,7 +35,6 @@ Activity::Activity(const QString& identifier, const QString& appId, const int64_
     mProcessId(processId),
     mFocus(false)
 {
-    setup();
 }
 
 Activity::~Activity()
@@ -122,6 +122,8 @@ void Activity::handleActivityResponse(LSMessage *message)
         return;
 
     mId = response.value("activityId").toInt(-1);
+
+    qCDebug(lcActivity) << "Got activity id" << mId << "for" << mIdentifier;
 }
 
 int Activity::id() const
@@ -149,6 +151,8 @@ void Activity::focus()
         return;
     }
 
+    qCDebug(lcActivity) << "Focused activity" << mId << "for" << mIdentifier;
+
     mFocus = true;
 }
 
@@ -172,6 +176,8 @@ void Activity::unfocus()
         return;
     }
 
+    qCDebug(lcActivity) << "Unfocused activity" << mId << "for" << mIdentifier;
+
     mFocus = false;
 }
 
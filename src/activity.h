@@ -30,6 +30,8 @@ public:
     Activity(const QString& identifier, const QString& appId, const int64_t processId);
     ~Activity();
 
+    void setup();
+
     int id() const;
 
     void focus();
@@ -46,7 +48,6 @@ private:
     QString mIdentifier;
     bool mFocus;
 
-    void setup();
     void handleActivityResponse(LSMessage *message);
 };
 
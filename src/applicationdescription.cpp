@@ -27,7 +27,9 @@ namespace luna
 {
 
 ApplicationDescription::ApplicationDescription() :
-    mHeadless(false)
+    mHeadless(false),
+    mLaunchHidden(false),
+    mHiddenLaunchMode("defer")
 {
 }
 
@@ -44,7 +46,10 @@ ApplicationDescription::ApplicationDescription(const ApplicationDescription& oth
     mUrlsAllowed(other.urlsAllowed()),
     mUserAgent(other.userAgent()),
     mLoadingAnimationDisabled(other.loadingAnimationDisabled()),
-    mAllowCrossDomainAccess(other.allowCrossDomainAccess())
+    mAllowCrossDomainAccess(other.allowCrossDomainAccess()),
+    mRenderProfile(other.renderProfile()),
+    mLaunchHidden(other.launchHidden()),
+    mHiddenLaunchMode(other.hiddenLaunchMode())
 {
 }
 
@@ -55,7 +60,9 @@ ApplicationDescription::ApplicationDescription(const QString &data) :
     mApplicationBasePath(""),
     mUserAgent(""),
     mLoadingAnimationDisabled(false),
-    mAllowCrossDomainAccess(false)
+    mAllowCrossDomainAccess(false),
+    mLaunchHidden(false),
+    mHiddenLaunchMode("defer")
 {
     initializeFromData(data);
 }
@@ -130,6 +137,24 @@ void ApplicationDescription::initializeFromData(const QString &data)
 
     if (rootObject.contains("allowCrossDomainAccess") && rootObject.value("allowCrossDomainAccess").isBool())
         mAllowCrossDomainAccess = rootObject.value("allowCrossDomainAccess").toBool();
+
+    if (rootObject.contains("renderProfile") && rootObject.value("renderProfile").isString())
+        mRenderProfile = rootObject.value("renderProfile").toString();
+
+    // The launcher is always started in the background and only shown once
+    // the user asks for it
+    mLaunchHidden = (mId == "com.palm.launcher");
+
+    if (rootObject.contains("launchHidden") && rootObject.value("launchHidden").isBool())
+        mLaunchHidden = rootObject.value("launchHidden").toBool();
+
+    if (rootObject.contains("hiddenLaunchMode") && rootObject.value("hiddenLaunchMode").isString()) {
+        QString mode = rootObject.value("hiddenLaunchMode").toString();
+        if (mode == "defer" || mode == "preload")
+            mHiddenLaunchMode = mode;
+        else
+            qWarning() << "Ignoring unknown hidden launch mode" << mode << "for app" << mId;
+    }
 }
 
 QUrl ApplicationDescription::locateEntryPoint(const QString &entryPoint)
@@ -222,4 +247,19 @@ bool ApplicationDescription::allowCrossDomainAccess() const
     return mAllowCrossDomainAccess;
 }
 
+QString ApplicationDescription::renderProfile() const
+{
+    return mRenderProfile;
+}
+
+bool ApplicationDescription::launchHidden() const
+{
+    return mLaunchHidden;
+}
+
+QString ApplicationDescription::hiddenLaunchMode() const
+{
+    return mHiddenLaunchMode;
+}
+
 }
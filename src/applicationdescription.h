@@ -37,6 +37,8 @@ class ApplicationDescription : public QObject
     Q_PROPERTY(bool flickable READ flickable CONSTANT)
     Q_PROPERTY(bool internetConnectivityRequired READ internetConnectivityRequired CONSTANT)
     Q_PROPERTY(bool loadingAnimationDisabled READ loadingAnimationDisabled CONSTANT)
+    Q_PROPERTY(bool launchHidden READ launchHidden CONSTANT)
+    Q_PROPERTY(QString hiddenLaunchMode READ hiddenLaunchMode CONSTANT)
 
 public:
     ApplicationDescription();
@@ -55,6 +57,9 @@ public:
     QString userAgent() const;
     bool loadingAnimationDisabled() const;
     bool allowCrossDomainAccess() const;
+    QString renderProfile() const;
+    bool launchHidden() const;
+    QString hiddenLaunchMode() const;
 
     QString pluginName() const;
     QString basePath() const;
@@ -75,6 +80,9 @@ private:
     QString mUserAgent;
     bool mLoadingAnimationDisabled;
     bool mAllowCrossDomainAccess;
+    QString mRenderProfile;
+    bool mLaunchHidden;
+    QString mHiddenLaunchMode;
 
     void initializeFromData(const QString &data);
     QUrl locateEntryPoint(const QString &entryPoint);
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include "applicationhistory.h"
+#include "logging.h"
+
+#define APPLICATION_HISTORY_SAVE_DELAY  5000
+
+namespace luna
+{
+
+ApplicationHistory* ApplicationHistory::instance()
+{
+    static ApplicationHistory* instance = 0;
+
+    if (!instance)
+        instance = new ApplicationHistory();
+
+    return instance;
+}
+
+ApplicationHistory::ApplicationHistory()
+{
+    mSaveTimer.setSingleShot(true);
+    mSaveTimer.setInterval(APPLICATION_HISTORY_SAVE_DELAY);
+    connect(&mSaveTimer, SIGNAL(timeout()), this, SLOT(onSave()));
+
+    QString cacheHome = qgetenv("XDG_CACHE_HOME");
+    if (!cacheHome.isEmpty())
+        mPath = QString("%1/LunaWebAppMgr/history.json").arg(cacheHome);
+
+    load();
+}
+
+void ApplicationHistory::load()
+{
+    if (mPath.isEmpty())
+        return;
+
+    QFile file(mPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    if (!document.isObject()) {
+        qWarning() << "Ignoring corrupt application history" << mPath;
+        return;
+    }
+
+    mApps = document.object();
+}
+
+void ApplicationHistory::scheduleSave()
+{
+    // Updates come in bursts so don't hit the disk for every single one
+    if (!mSaveTimer.isActive())
+        mSaveTimer.start();
+}
+
+void ApplicationHistory::flush()
+{
+    if (!mSaveTimer.isActive())
+        return;
+
+    mSaveTimer.stop();
+    onSave();
+}
+
+void ApplicationHistory::onSave()
+{
+    if (mPath.isEmpty())
+        return;
+
+    QDir().mkpath(QFileInfo(mPath).absolutePath());
+
+    QSaveFile file(mPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Failed to write application history" << mPath;
+        return;
+    }
+
+    file.write(QJsonDocument(mApps).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+qint64 ApplicationHistory::peakMemory(const QString &appId) const
+{
+    return static_cast<qint64>(mApps.value(appId).toObject().value("peakMemory").toDouble(0));
+}
+
+void ApplicationHistory::recordMemory(const QString &appId, qint64 residentMemory)
+{
+    QJsonObject app = mApps.value(appId).toObject();
+    qint64 peak = static_cast<qint64>(app.value("peakMemory").toDouble(0));
+
+    // Follow increases right away but let the peak decay slowly so a single
+    // unusual run doesn't dominate the estimate forever
+    qint64 updated = residentMemory >= peak ? residentMemory : (peak * 7 + residentMemory) / 8;
+    if (updated == peak)
+        return;
+
+    app.insert("peakMemory", static_cast<double>(updated));
+    mApps.insert(appId, app);
+
+    qCDebug(lcMemory) << "Peak memory of" << appId << "is now" << updated << "kB";
+
+    scheduleSave();
+}
+
+qint64 ApplicationHistory::stageReadyDelay(const QString &appId) const
+{
+    return static_cast<qint64>(mApps.value(appId).toObject().value("stageReadyDelay").toDouble(-1));
+}
+
+bool ApplicationHistory::stageReadyMissed(const QString &appId) const
+{
+    return mApps.value(appId).toObject().value("stageReadyMissed").toBool(false);
+}
+
+void ApplicationHistory::recordStageReady(const QString &appId, qint64 delay)
+{
+    QJsonObject app = mApps.value(appId).toObject();
+    qint64 previous = static_cast<qint64>(app.value("stageReadyDelay").toDouble(-1));
+
+    // Same as for the memory peak: slow runs count right away, fast ones
+    // only bring the estimate down gradually
+    qint64 updated = (previous < 0 || delay >= previous) ? delay : (previous * 3 + delay) / 4;
+    if (updated == previous && !app.value("stageReadyMissed").toBool(false))
+        return;
+
+    app.insert("stageReadyDelay", static_cast<double>(updated));
+    app.remove("stageReadyMissed");
+    mApps.insert(appId, app);
+
+    qCDebug(lcLaunch) << "Stage of" << appId << "is now expected to be ready after" << updated << "ms";
+
+    scheduleSave();
+}
+
+void ApplicationHistory::recordStageReadyMissed(const QString &appId)
+{
+    QJsonObject app = mApps.value(appId).toObject();
+    if (app.value("stageReadyMissed").toBool(false))
+        return;
+
+    app.insert("stageReadyMissed", true);
+    mApps.insert(appId, app);
+
+    qCDebug(lcLaunch) << "Stage of" << appId << "didn't become ready in time";
+
+    scheduleSave();
+}
+
+} // namespace luna
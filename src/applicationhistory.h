@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef APPLICATIONHISTORY_H
+#define APPLICATIONHISTORY_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QString>
+#include <QTimer>
+
+namespace luna
+{
+
+/*
+ * Persistent per application statistics gathered over previous runs, stored
+ * as JSON in the cache directory.
+ */
+class ApplicationHistory : public QObject
+{
+    Q_OBJECT
+
+public:
+    static ApplicationHistory* instance();
+
+    qint64 peakMemory(const QString &appId) const;
+    void recordMemory(const QString &appId, qint64 residentMemory);
+
+    qint64 stageReadyDelay(const QString &appId) const;
+    bool stageReadyMissed(const QString &appId) const;
+    void recordStageReady(const QString &appId, qint64 delay);
+    void recordStageReadyMissed(const QString &appId);
+
+    void flush();
+
+private Q_SLOTS:
+    void onSave();
+
+private:
+    ApplicationHistory();
+
+    void load();
+    void scheduleSave();
+
+    QString mPath;
+    QJsonObject mApps;
+    QTimer mSaveTimer;
+};
+
+} // namespace luna
+
+#endif // APPLICATIONHISTORY_H
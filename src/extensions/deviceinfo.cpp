@@ -24,20 +24,48 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QMutex>
+#include <QThread>
 
 #include <Settings.h>
 
 static DeviceInfo* s_instance = 0;
+static QMutex s_instanceLock;
 static const int kTouchableHeight = 48;
 
+class DeviceInfoThread : public QThread
+{
+protected:
+    void run()
+    {
+        DeviceInfo::instance();
+    }
+};
+
 DeviceInfo* DeviceInfo::instance()
 {
+    // The instance might be created from the background thread started
+    // by prepareInBackground so a caller on the bridge path waits for it
+    // instead of gathering everything a second time
+    QMutexLocker locker(&s_instanceLock);
+
     if (G_UNLIKELY(s_instance == 0))
         new DeviceInfo;
 
     return s_instance;
 }
 
+void DeviceInfo::prepareInBackground()
+{
+    // Make sure the settings are initialized by the calling thread as
+    // they aren't safe to be created concurrently
+    Settings::LunaSettings();
+
+    DeviceInfoThread *thread = new DeviceInfoThread;
+    QObject::connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+    thread->start(QThread::LowPriority);
+}
+
 DeviceInfo::DeviceInfo()
 {
     s_instance = this;
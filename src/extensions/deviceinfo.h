@@ -26,6 +26,7 @@ class DeviceInfo
 {
 public:
     static DeviceInfo* instance();
+    static void prepareInBackground();
     ~DeviceInfo();
 
     QString jsonString() const;
@@ -21,6 +21,7 @@
 #include <QtWebKit/private/qquickwebview_p.h>
 
 #include "../webapplicationwindow.h"
+#include "../logging.h"
 #include "inappbrowserextension.h"
 
 namespace luna
@@ -48,7 +49,7 @@ void InAppBrowserExtension::open(const QString &url, const QString &frameName)
     if (mApplicationWindow->headless())
         return;
 
-    qDebug() << Q_FUNC_INFO << url << frameName;
+    qCDebug(lcExtensions) << Q_FUNC_INFO << url << frameName;
 
     mFrameName = frameName;
 
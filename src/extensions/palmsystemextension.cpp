@@ -18,6 +18,7 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
+#include <QHash>
 #include <QQuickView>
 #include <QFile>
 #include <QFileInfo>
@@ -32,6 +33,7 @@
 #include "../webapplication.h"
 #include "../webapplicationwindow.h"
 #include "../systemtime.h"
+#include "../logging.h"
 #include "palmsystemextension.h"
 #include "deviceinfo.h"
 
@@ -50,53 +52,53 @@ PalmSystemExtension::PalmSystemExtension(WebApplicationWindow *applicationWindow
 
 void PalmSystemExtension::stageReady()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
     mApplicationWindow->stageReady();
 }
 
 void PalmSystemExtension::activate()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
     mApplicationWindow->focus();
 }
 
 void PalmSystemExtension::deactivate()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
     mApplicationWindow->unfocus();
 }
 
 void PalmSystemExtension::stagePreparing()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
     mApplicationWindow->stagePreparing();
 }
 
 void PalmSystemExtension::show()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
     mApplicationWindow->show();
 }
 
 void PalmSystemExtension::hide()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
     mApplicationWindow->hide();
 }
 
 void PalmSystemExtension::setWindowProperties(const QString &properties)
 {
-    qDebug() << __PRETTY_FUNCTION__ << properties;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << properties;
 }
 
 void PalmSystemExtension::enableFullScreenMode(bool enable)
 {
-    qDebug() << __PRETTY_FUNCTION__ << enable;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << enable;
 }
 
 void PalmSystemExtension::removeBannerMessage(int id)
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
 
     QString appId = mApplicationWindow->application()->id();
 
@@ -112,7 +114,7 @@ void PalmSystemExtension::removeBannerMessage(int id)
 
 void PalmSystemExtension::clearBannerMessages()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
 
     QString appId = mApplicationWindow->application()->id();
 
@@ -122,7 +124,7 @@ void PalmSystemExtension::clearBannerMessages()
 
 void PalmSystemExtension::keepAlive(bool keep)
 {
-    qDebug() << __PRETTY_FUNCTION__ << keep;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << keep;
     mApplicationWindow->setKeepAlive(keep);
 }
 
@@ -135,7 +137,36 @@ void PalmSystemExtension::markFirstUseDone()
 
 void PalmSystemExtension::setProperty(const QString &name, const QVariant &value)
 {
-    qDebug() << __PRETTY_FUNCTION__ << name << value;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << name << value;
+}
+
+PalmSystemExtension::Property PalmSystemExtension::lookupProperty(const QString &name)
+{
+    static QHash<QString, Property> properties;
+
+    if (properties.isEmpty()) {
+        properties.insert("launchParams", PropertyLaunchParams);
+        properties.insert("hasAlphaHole", PropertyHasAlphaHole);
+        properties.insert("locale", PropertyLocale);
+        properties.insert("locales.UI", PropertyLocale);
+        properties.insert("localeRegion", PropertyLocaleRegion);
+        properties.insert("timeFormat", PropertyTimeFormat);
+        properties.insert("timeZone", PropertyTimeZone);
+        properties.insert("timezone", PropertyTimeZone);
+        properties.insert("isMinimal", PropertyIsMinimal);
+        properties.insert("identifier", PropertyIdentifier);
+        properties.insert("screenOrientation", PropertyScreenOrientation);
+        properties.insert("windowOrientation", PropertyWindowOrientation);
+        properties.insert("specifiedWindowOrientation", PropertySpecifiedWindowOrientation);
+        properties.insert("videoOrientation", PropertyVideoOrientation);
+        properties.insert("deviceInfo", PropertyDeviceInfo);
+        properties.insert("isActivated", PropertyIsActivated);
+        properties.insert("activityId", PropertyActivityId);
+        properties.insert("phoneRegion", PropertyPhoneRegion);
+        properties.insert("version", PropertyVersion);
+    }
+
+    return properties.value(name, PropertyUnknown);
 }
 
 QString PalmSystemExtension::getProperty(const QJsonArray &params)
@@ -143,45 +174,42 @@ QString PalmSystemExtension::getProperty(const QJsonArray &params)
     if (params.count() != 1 || !params.at(0).isString())
         return QString("");
 
-    QString name = params.at(0).toString();
-    QString result = "";
-
-    if (name == "launchParams")
-        result = mApplicationWindow->application()->parameters();
-    else if (name == "hasAlphaHole")
-        result = QString("false");
-    else if (name == "locale" || name == "locales.UI")
-        result = LocalePreferences::instance()->locale();
-    else if (name == "localeRegion")
-        result = LocalePreferences::instance()->localeRegion();
-    else if (name == "timeFormat")
-        result = LocalePreferences::instance()->timeFormat();
-    else if (name == "timeZone" || name == "timezone")
-        result = SystemTime::instance()->timezone();
-    else if (name == "isMinimal")
-        result = QString("false");
-    else if (name == "identifier")
-        result = mApplicationWindow->application()->identifier();
-    else if (name == "screenOrientation")
-        result = QString("");
-    else if (name == "windowOrientation")
-        result = QString("");
-    else if (name == "specifiedWindowOrientation")
-        result = QString("");
-    else if (name == "videoOrientation")
-        result = QString("");
-    else if (name == "deviceInfo")
-        result = DeviceInfo::instance()->jsonString();
-    else if (name == "isActivated")
-        result = QString(mApplicationWindow->active() ? "true" : "false");
-    else if (name == "activityId")
-        result = QString("%1").arg(mApplicationWindow->application()->activityId());
-    else if (name == "phoneRegion")
-        result = LocalePreferences::instance()->phoneRegion();
-    else if (name == "version")
-        result = QString(QTWEBKIT_VERSION_STR);
-
-    return result;
+    switch (lookupProperty(params.at(0).toString())) {
+    case PropertyLaunchParams:
+        return mApplicationWindow->application()->parameters();
+    case PropertyHasAlphaHole:
+    case PropertyIsMinimal:
+        return QString("false");
+    case PropertyLocale:
+        return LocalePreferences::instance()->locale();
+    case PropertyLocaleRegion:
+        return LocalePreferences::instance()->localeRegion();
+    case PropertyTimeFormat:
+        return LocalePreferences::instance()->timeFormat();
+    case PropertyTimeZone:
+        return SystemTime::instance()->timezone();
+    case PropertyIdentifier:
+        return mApplicationWindow->application()->identifier();
+    case PropertyScreenOrientation:
+    case PropertyWindowOrientation:
+    case PropertySpecifiedWindowOrientation:
+    case PropertyVideoOrientation:
+        return QString("");
+    case PropertyDeviceInfo:
+        return DeviceInfo::instance()->jsonString();
+    case PropertyIsActivated:
+        return QString(mApplicationWindow->active() ? "true" : "false");
+    case PropertyActivityId:
+        return QString("%1").arg(mApplicationWindow->application()->activityId());
+    case PropertyPhoneRegion:
+        return LocalePreferences::instance()->phoneRegion();
+    case PropertyVersion:
+        return QString(QTWEBKIT_VERSION_STR);
+    case PropertyUnknown:
+        break;
+    }
+
+    return QString("");
 }
 
 QString PalmSystemExtension::handleSynchronousCall(const QString& funcName, const QJsonArray& params)
@@ -202,7 +230,7 @@ QString PalmSystemExtension::handleSynchronousCall(const QString& funcName, cons
 
 QString PalmSystemExtension::getResource(const QJsonArray& params)
 {
-    qDebug() << __PRETTY_FUNCTION__ << params;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << params;
 
     if (params.count() != 2 || !params.at(0).isString())
         return QString("");
@@ -212,7 +240,7 @@ QString PalmSystemExtension::getResource(const QJsonArray& params)
         path = path.right(path.size() - 7);
 
     if (!mApplicationWindow->application()->validateResourcePath(path)) {
-        qDebug() << "WARNING: Access to path" << path << "is not allowed";
+        qCDebug(lcExtensions) << "WARNING: Access to path" << path << "is not allowed";
         return QString("");
     }
 
@@ -227,7 +255,7 @@ QString PalmSystemExtension::getResource(const QJsonArray& params)
 
 QString PalmSystemExtension::getIdentifierForFrame(const QJsonArray &params)
 {
-    qDebug() << __PRETTY_FUNCTION__ << params;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << params;
 
     if (params.count() != 2 || !params.at(0).isString() || !params.at(0).isString())
         return QString("");
@@ -240,7 +268,7 @@ QString PalmSystemExtension::getIdentifierForFrame(const QJsonArray &params)
 
 QString PalmSystemExtension::addBannerMessage(const QJsonArray &params)
 {
-    qDebug() << __PRETTY_FUNCTION__ << params;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << params;
 
     if (params.count() != 7)
         return QString("");
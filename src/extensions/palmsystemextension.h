@@ -32,6 +32,29 @@ class PalmSystemExtension : public BaseExtension
 public:
     explicit PalmSystemExtension(WebApplicationWindow *applicationWindow, QObject *parent = 0);
 
+    enum Property {
+        PropertyUnknown = 0,
+        PropertyLaunchParams,
+        PropertyHasAlphaHole,
+        PropertyLocale,
+        PropertyLocaleRegion,
+        PropertyTimeFormat,
+        PropertyTimeZone,
+        PropertyIsMinimal,
+        PropertyIdentifier,
+        PropertyScreenOrientation,
+        PropertyWindowOrientation,
+        PropertySpecifiedWindowOrientation,
+        PropertyVideoOrientation,
+        PropertyDeviceInfo,
+        PropertyIsActivated,
+        PropertyActivityId,
+        PropertyPhoneRegion,
+        PropertyVersion
+    };
+
+    static Property lookupProperty(const QString &name);
+
     QString handleSynchronousCall(const QString& funcName, const QJsonArray& params);
 
 public Q_SLOTS:
@@ -22,6 +22,7 @@
 #include <QDBusAbstractAdaptor>
 
 #include "wifimanager.h"
+#include "../logging.h"
 
 WiFiManager::WiFiManager(luna::ApplicationEnvironment *environment, QObject *parent) :
     luna::BaseExtension("WiFiManager", environment, parent),
@@ -47,7 +48,7 @@ WiFiManager::WiFiManager(luna::ApplicationEnvironment *environment, QObject *par
     connect(&mAgent, SIGNAL(userInputRequested(const QString&, const QVariantMap&)),
             this, SLOT(handleUserInputRequested(const QString&, const QVariantMap&)));
 
-    qDebug() << "Registering WiFiManager extension ...";
+    qCDebug(lcExtensions) << "Registering WiFiManager extension ...";
     environment->registerUserScript(QUrl("qrc:///extensions/WiFiManager.js"));
 }
 
@@ -88,11 +89,16 @@ void WiFiManager::technologiesChanged()
 }
 
 QString WiFiManager::createNetworksResponse()
+{
+    return createNetworksResponse(mManager->getServices("wifi"));
+}
+
+QString WiFiManager::createNetworksResponse(const QVector<NetworkService*> &networks)
 {
     QJsonDocument document;
     QJsonArray networksArray;
 
-    foreach(NetworkService *network, mManager->getServices("wifi")) {
+    foreach(NetworkService *network, networks) {
         QJsonObject networkObj;
 
         networkObj.insert("path", QJsonValue(network->path()));
@@ -137,7 +143,7 @@ void WiFiManager::scanFinished()
 
 void WiFiManager::handleUserInputRequested(const QString &servicePath, const QVariantMap &fields)
 {
-    qDebug() << __PRETTY_FUNCTION__ << servicePath << fields;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << servicePath << fields;
 
     if (!mConnecting)
         return;
@@ -173,14 +179,14 @@ void WiFiManager::retrieveNetworks(int scid, int ecid)
 
 void WiFiManager::connectRequestFailed(const QString& error)
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
 
     finishConnectionProcess(false, error);
 }
 
 void WiFiManager::networkConnected(bool connected)
 {
-    qDebug() << __PRETTY_FUNCTION__ << connected;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << connected;
 
     bool success = false;
 
@@ -192,7 +198,7 @@ void WiFiManager::networkConnected(bool connected)
 
 void WiFiManager::finishConnectionProcess(bool success, const QString &error)
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__;
 
     if (mConnecting)
         callback(success ? mConnectCallbacks.first : mConnectCallbacks.second, error);
@@ -216,7 +222,7 @@ void WiFiManager::finishConnectionProcess(bool success, const QString &error)
 
 void WiFiManager::connectNetwork(int scid, int ecid, const QString &network)
 {
-    qDebug() << __PRETTY_FUNCTION__ << network;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << network;
 
     if (mConnecting) {
         callback(ecid, "Already connecting to a network");
@@ -264,7 +270,7 @@ void WiFiManager::connectNetwork(int scid, int ecid, const QString &network)
 
 void WiFiManager::disconnectNetwork(const QString &path)
 {
-    qDebug() << __PRETTY_FUNCTION__ << path;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << path;
 
     if (mConnecting)
         return;
@@ -277,7 +283,7 @@ void WiFiManager::disconnectNetwork(const QString &path)
 
 void WiFiManager::setNetworkOption(const QString &path, const QString &key, const QVariant &value)
 {
-    qDebug() << __PRETTY_FUNCTION__ << path << key << value;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << path << key << value;
 
     QVariantMap emptyProperties;
     NetworkService networkToConfigure(path, emptyProperties, 0);
@@ -285,7 +291,7 @@ void WiFiManager::setNetworkOption(const QString &path, const QString &key, cons
 
 void WiFiManager::removeNetwork(const QString &path)
 {
-    qDebug() << __PRETTY_FUNCTION__ << path;
+    qCDebug(lcExtensions) << __PRETTY_FUNCTION__ << path;
 
     QVariantMap emptyProperties;
     NetworkService networkToRemove(path, emptyProperties, 0);
@@ -20,6 +20,7 @@
 
 #include <QObject>
 #include <QList>
+#include <QVector>
 #include <networkmanager.h>
 #include <networktechnology.h>
 #include <networkservice.h>
@@ -36,6 +37,8 @@ public:
 
     void initialize();
 
+    static QString createNetworksResponse(const QVector<NetworkService*> &networks);
+
 public Q_SLOTS:
     void setPowered(bool powered);
     void retrieveNetworks(int scid, int ecid);
@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QMutexLocker>
+#include <QQuickWindow>
+#include <QStringList>
+
+#include "framestatistics.h"
+
+// All times in ms
+#define FRAME_BUDGET    17
+#define IDLE_GAP        500
+
+namespace luna
+{
+
+// Upper bounds of the histogram buckets, the last bucket is open ended
+static const int bucketLimits[] = { 8, 17, 25, 33, 50, 100, 250, 0 };
+static const int bucketCount = sizeof(bucketLimits) / sizeof(bucketLimits[0]);
+
+static const char* workNames[] = { "script", "launch", "service" };
+
+static QMutex sWorkLock;
+static int sWorkActive[FrameStatistics::WorkCount];
+static qint64 sWorkLastEnd[FrameStatistics::WorkCount];
+
+static qint64 now()
+{
+    static QElapsedTimer timer;
+
+    if (!timer.isValid())
+        timer.start();
+
+    return timer.elapsed();
+}
+
+FrameStatistics::WorkScope::WorkScope(Work work) :
+    mWork(work)
+{
+    beginWork(mWork);
+}
+
+FrameStatistics::WorkScope::~WorkScope()
+{
+    endWork(mWork);
+}
+
+void FrameStatistics::beginWork(Work work)
+{
+    QMutexLocker locker(&sWorkLock);
+    sWorkActive[work]++;
+}
+
+void FrameStatistics::endWork(Work work)
+{
+    QMutexLocker locker(&sWorkLock);
+    sWorkActive[work]--;
+    sWorkLastEnd[work] = now();
+}
+
+FrameStatistics::Counters::Counters() :
+    lastSwap(-1),
+    frames(0),
+    overBudget(0),
+    longest(0),
+    histogram(bucketCount, 0),
+    attributed(WorkCount + 1, 0)
+{
+}
+
+FrameStatistics::FrameStatistics(QQuickWindow *window, QObject *parent) :
+    QObject(parent),
+    mCounters(new Counters)
+{
+    now();
+
+    // Emitted on the render thread, so take the time right there. The
+    // connection holds its own reference to the counters as a swap might
+    // still be recorded while we're destroyed on the main thread.
+    QSharedPointer<Counters> counters = mCounters;
+    mConnection = connect(window, &QQuickWindow::frameSwapped, [counters]() {
+        counters->recordSwap();
+    });
+}
+
+FrameStatistics::~FrameStatistics()
+{
+    disconnect(mConnection);
+}
+
+void FrameStatistics::Counters::recordSwap()
+{
+    qint64 swap = now();
+
+    QMutexLocker locker(&lock);
+
+    qint64 previous = lastSwap;
+    lastSwap = swap;
+
+    // Nothing is rendered while the content doesn't change, so a long gap
+    // is an idle window and not a slow frame
+    if (previous < 0 || swap - previous > IDLE_GAP)
+        return;
+
+    qint64 interval = swap - previous;
+
+    frames++;
+    longest = qMax(longest, interval);
+
+    int bucket = 0;
+    while (bucketLimits[bucket] && interval >= bucketLimits[bucket])
+        bucket++;
+    histogram[bucket]++;
+
+    if (interval < FRAME_BUDGET)
+        return;
+
+    overBudget++;
+
+    bool busy = false;
+    QMutexLocker workLocker(&sWorkLock);
+    for (int work = 0; work < WorkCount; work++) {
+        if (sWorkActive[work] > 0 || sWorkLastEnd[work] >= previous) {
+            attributed[work]++;
+            busy = true;
+        }
+    }
+
+    if (!busy)
+        attributed[WorkCount]++;
+}
+
+QJsonObject FrameStatistics::toJson() const
+{
+    QMutexLocker locker(&mCounters->lock);
+
+    QJsonArray histogram;
+    for (int n = 0; n < bucketCount; n++) {
+        QJsonObject bucket;
+        if (bucketLimits[n])
+            bucket.insert("below", bucketLimits[n]);
+        bucket.insert("frames", mCounters->histogram.at(n));
+        histogram.append(bucket);
+    }
+
+    QJsonObject longFrames;
+    for (int work = 0; work < WorkCount; work++)
+        longFrames.insert(workNames[work], mCounters->attributed.at(work));
+    longFrames.insert("unattributed", mCounters->attributed.at(WorkCount));
+
+    QJsonObject result;
+    result.insert("frames", mCounters->frames);
+    result.insert("overBudget", mCounters->overBudget);
+    result.insert("budget", FRAME_BUDGET);
+    result.insert("longest", mCounters->longest);
+    result.insert("histogram", histogram);
+    result.insert("longFrames", longFrames);
+
+    return result;
+}
+
+QString FrameStatistics::summary() const
+{
+    QMutexLocker locker(&mCounters->lock);
+
+    QStringList longFrames;
+    for (int work = 0; work < WorkCount; work++)
+        longFrames << QString("%1=%2").arg(workNames[work]).arg(mCounters->attributed.at(work));
+    longFrames << QString("unattributed=%1").arg(mCounters->attributed.at(WorkCount));
+
+    return QString("frames=%1 overBudget=%2 longest=%3ms %4")
+            .arg(mCounters->frames).arg(mCounters->overBudget).arg(mCounters->longest)
+            .arg(longFrames.join(" "));
+}
+
+void FrameStatistics::reset()
+{
+    QMutexLocker locker(&mCounters->lock);
+
+    mCounters->frames = 0;
+    mCounters->overBudget = 0;
+    mCounters->longest = 0;
+    mCounters->histogram.fill(0);
+    mCounters->attributed.fill(0);
+}
+
+} // namespace luna
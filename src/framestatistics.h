@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef FRAMESTATISTICS_H
+#define FRAMESTATISTICS_H
+
+#include <QObject>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+class QQuickWindow;
+
+namespace luna
+{
+
+/*
+ * Records the intervals between the frames of a window in a histogram and
+ * counts the ones over budget. Long frames are attributed to whatever the
+ * manager was busy with while they were produced: evaluating scripts,
+ * constructing applications or handling service calls.
+ *
+ * The frames are recorded on the render thread into counters which are
+ * shared with the connection, so a frame being recorded while the window
+ * goes away never touches freed memory.
+ */
+class FrameStatistics : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Work {
+        WorkScript = 0,
+        WorkLaunch,
+        WorkService,
+        WorkCount
+    };
+
+    // Marks the manager as busy with the given work for its lifetime
+    class WorkScope
+    {
+    public:
+        explicit WorkScope(Work work);
+        ~WorkScope();
+
+    private:
+        Work mWork;
+    };
+
+    static void beginWork(Work work);
+    static void endWork(Work work);
+
+    explicit FrameStatistics(QQuickWindow *window, QObject *parent = 0);
+    ~FrameStatistics();
+
+    QJsonObject toJson() const;
+    QString summary() const;
+    void reset();
+
+private:
+    struct Counters {
+        Counters();
+        void recordSwap();
+
+        QMutex lock;
+        qint64 lastSwap;
+        int frames;
+        int overBudget;
+        qint64 longest;
+        QVector<int> histogram;
+        QVector<int> attributed;
+    };
+
+    QSharedPointer<Counters> mCounters;
+    QMetaObject::Connection mConnection;
+};
+
+} // namespace luna
+
+#endif // FRAMESTATISTICS_H
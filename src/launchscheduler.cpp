@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "launchscheduler.h"
+#include "logging.h"
+
+#define LAUNCH_SCHEDULER_MAX_LOADS      2
+#define LAUNCH_SCHEDULER_MAX_QUEUED     32
+#define LAUNCH_SCHEDULER_LOAD_TIMEOUT   10000
+
+namespace luna
+{
+
+LaunchScheduler::LaunchScheduler(QObject *parent) :
+    QObject(parent),
+    mProcessScheduled(false)
+{
+}
+
+bool LaunchScheduler::schedule(const QString &appId, Priority priority, const Job &job, bool tracksLoad)
+{
+    if (mQueue.size() >= LAUNCH_SCHEDULER_MAX_QUEUED) {
+        qCWarning(lcLaunch) << "Rejecting job for" << appId << "as" << mQueue.size() << "jobs are queued already";
+        return false;
+    }
+
+    Entry entry;
+    entry.appId = appId;
+    entry.priority = priority;
+    entry.job = job;
+    entry.tracksLoad = tracksLoad;
+
+    // Keep the queue sorted by priority but in order of arrival within one
+    int n = 0;
+    while (n < mQueue.size() && mQueue.at(n).priority <= priority)
+        n++;
+    mQueue.insert(n, entry);
+
+    qCDebug(lcLaunch) << "Queued job for" << appId << "with priority" << priority
+                      << "queued" << mQueue.size() << "in progress" << mInProgress.size();
+
+    scheduleProcessing();
+
+    return true;
+}
+
+void LaunchScheduler::finished(const QString &appId)
+{
+    if (!mInProgress.contains(appId))
+        return;
+
+    mInProgress.remove(appId);
+
+    // Might be called from within the timeout of the timer itself
+    QTimer *timer = mLoadTimers.take(appId);
+    if (timer)
+        timer->deleteLater();
+
+    qCDebug(lcLaunch) << "Load of" << appId << "finished, in progress" << mInProgress.size();
+
+    scheduleProcessing();
+}
+
+void LaunchScheduler::cancel(const QString &appId)
+{
+    for (int n = mQueue.size() - 1; n >= 0; n--) {
+        if (mQueue.at(n).appId == appId)
+            mQueue.removeAt(n);
+    }
+
+    finished(appId);
+}
+
+int LaunchScheduler::queued() const
+{
+    return mQueue.size();
+}
+
+int LaunchScheduler::inProgress() const
+{
+    return mInProgress.size();
+}
+
+bool LaunchScheduler::foregroundLoadInProgress() const
+{
+    Q_FOREACH(Priority priority, mInProgress.values()) {
+        if (priority == PriorityForeground || priority == PriorityLauncher)
+            return true;
+    }
+
+    return false;
+}
+
+void LaunchScheduler::scheduleProcessing()
+{
+    if (mProcessScheduled)
+        return;
+
+    mProcessScheduled = true;
+    QMetaObject::invokeMethod(this, "onProcessQueue", Qt::QueuedConnection);
+}
+
+void LaunchScheduler::onProcessQueue()
+{
+    mProcessScheduled = false;
+
+    // Entries waiting for a load slot don't hold up the ones which don't
+    // need one, like relaunches of running applications. Loads still start
+    // in priority order: once one has to wait all later ones do too.
+    bool loadsBlocked = false;
+    int n = 0;
+    while (n < mQueue.size()) {
+        const Entry &entry = mQueue.at(n);
+
+        if (entry.tracksLoad) {
+            if (loadsBlocked || mInProgress.size() >= LAUNCH_SCHEDULER_MAX_LOADS) {
+                loadsBlocked = true;
+                n++;
+                continue;
+            }
+
+            if (entry.priority == PriorityBackground && foregroundLoadInProgress()) {
+                qCDebug(lcLaunch) << "Deferring background launch of" << entry.appId;
+                n++;
+                continue;
+            }
+        }
+
+        Entry current = mQueue.takeAt(n);
+
+        if (current.tracksLoad) {
+            mInProgress.insert(current.appId, current.priority);
+
+            // Don't let a page which never finishes loading block the queue
+            QTimer *timer = new QTimer(this);
+            timer->setSingleShot(true);
+            timer->setProperty("appId", current.appId);
+            connect(timer, SIGNAL(timeout()), this, SLOT(onLoadTimeout()));
+            timer->start(LAUNCH_SCHEDULER_LOAD_TIMEOUT);
+            mLoadTimers.insert(current.appId, timer);
+        }
+
+        qCDebug(lcLaunch) << "Starting job for" << current.appId << "with priority" << current.priority;
+
+        current.job();
+    }
+}
+
+void LaunchScheduler::onLoadTimeout()
+{
+    QString appId = sender()->property("appId").toString();
+
+    qCWarning(lcLaunch) << "Load of" << appId << "didn't finish in time, not waiting for it anymore";
+
+    finished(appId);
+}
+
+} // namespace luna
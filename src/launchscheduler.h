@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LAUNCHSCHEDULER_H
+#define LAUNCHSCHEDULER_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+
+namespace luna
+{
+
+/*
+ * Decides when queued launches and relaunches are carried out. Jobs run in
+ * priority order, only a limited number of page loads may be in flight at
+ * the same time and background launches wait until no foreground launch is
+ * loading anymore. Jobs which don't load anything never wait for a load
+ * slot. When the queue is full new jobs are rejected so the
+ * caller can report the manager as busy.
+ */
+class LaunchScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        PriorityForeground = 0,
+        PriorityLauncher,
+        PriorityRelaunch,
+        PriorityBackground
+    };
+
+    typedef std::function<void()> Job;
+
+    explicit LaunchScheduler(QObject *parent = 0);
+
+    bool schedule(const QString &appId, Priority priority, const Job &job, bool tracksLoad);
+    void finished(const QString &appId);
+    void cancel(const QString &appId);
+
+    int queued() const;
+    int inProgress() const;
+
+private Q_SLOTS:
+    void onProcessQueue();
+    void onLoadTimeout();
+
+private:
+    struct Entry {
+        QString appId;
+        Priority priority;
+        Job job;
+        bool tracksLoad;
+    };
+
+    QList<Entry> mQueue;
+    QMap<QString, Priority> mInProgress;
+    QMap<QString, QTimer*> mLoadTimers;
+    bool mProcessScheduled;
+
+    bool foregroundLoadInProgress() const;
+    void scheduleProcessing();
+};
+
+} // namespace luna
+
+#endif // LAUNCHSCHEDULER_H
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "localservicetransport.h"
+
+namespace luna
+{
+
+class LocalServiceRequest : public ServiceRequest
+{
+public:
+    LocalServiceRequest(const QByteArray &payload, bool subscription,
+                        const LocalServiceTransport::ResponseHandler &handler) :
+        mPayload(payload),
+        mSubscription(subscription),
+        mHandler(handler)
+    {
+    }
+
+    QByteArray payload() const { return mPayload; }
+    bool isSubscription() const { return mSubscription; }
+
+    void respond(const QByteArray &response)
+    {
+        if (mHandler)
+            mHandler(response);
+    }
+
+    LocalServiceTransport::ResponseHandler handler() const { return mHandler; }
+
+private:
+    QByteArray mPayload;
+    bool mSubscription;
+    LocalServiceTransport::ResponseHandler mHandler;
+};
+
+LocalServiceTransport::LocalServiceTransport(QObject *parent) :
+    QObject(parent),
+    mStarted(false),
+    mDispatchScheduled(false)
+{
+}
+
+void LocalServiceTransport::registerMethod(const QString &name, const Method &method)
+{
+    mMethods.insert(name, method);
+}
+
+void LocalServiceTransport::start()
+{
+    mStarted = true;
+
+    if (!mPendingCalls.isEmpty() && !mDispatchScheduled) {
+        mDispatchScheduled = true;
+        QMetaObject::invokeMethod(this, "onDispatchPendingCalls", Qt::QueuedConnection);
+    }
+}
+
+void LocalServiceTransport::subscribe(const QString &key, ServiceRequest &request)
+{
+    mSubscriptions[key].append(static_cast<LocalServiceRequest&>(request).handler());
+}
+
+void LocalServiceTransport::post(const QString &key, const QByteArray &payload)
+{
+    Q_FOREACH(const ResponseHandler &handler, mSubscriptions.value(key))
+        handler(payload);
+}
+
+void LocalServiceTransport::call(const QString &method, const QByteArray &payload,
+                                 const ResponseHandler &handler, bool subscribe)
+{
+    PendingCall call;
+    call.method = method;
+    call.payload = payload;
+    call.handler = handler;
+    call.subscribe = subscribe;
+
+    mPendingCalls.append(call);
+
+    if (mStarted && !mDispatchScheduled) {
+        mDispatchScheduled = true;
+        QMetaObject::invokeMethod(this, "onDispatchPendingCalls", Qt::QueuedConnection);
+    }
+}
+
+int LocalServiceTransport::pendingCalls() const
+{
+    return mPendingCalls.size();
+}
+
+void LocalServiceTransport::onDispatchPendingCalls()
+{
+    mDispatchScheduled = false;
+
+    // Only dispatch what was queued so far; calls made from within a handler
+    // are delivered with the next iteration like with the real bus
+    QList<PendingCall> calls = mPendingCalls;
+    mPendingCalls.clear();
+
+    Q_FOREACH(const PendingCall &call, calls) {
+        LocalServiceRequest request(call.payload, call.subscribe, call.handler);
+
+        Method method = mMethods.value(call.method);
+        if (!method) {
+            request.respond("{\"returnValue\":false,\"errorText\":\"Unknown method\"}");
+            continue;
+        }
+
+        method(request);
+    }
+}
+
+} // namespace luna
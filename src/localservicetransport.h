@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOCALSERVICETRANSPORT_H
+#define LOCALSERVICETRANSPORT_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+
+#include "servicetransport.h"
+
+namespace luna
+{
+
+/*
+ * In-process stand-in for the bus. Calls are queued and dispatched from the
+ * event loop like they would be when arriving from the hub so the manager
+ * sees the same ordering as in production.
+ */
+class LocalServiceTransport : public QObject, public ServiceTransport
+{
+    Q_OBJECT
+public:
+    typedef std::function<void(const QByteArray&)> ResponseHandler;
+
+    explicit LocalServiceTransport(QObject *parent = 0);
+
+    void registerMethod(const QString &name, const Method &method);
+    void start();
+
+    void subscribe(const QString &key, ServiceRequest &request);
+    void post(const QString &key, const QByteArray &payload);
+
+    void call(const QString &method, const QByteArray &payload,
+              const ResponseHandler &handler, bool subscribe = false);
+
+    int pendingCalls() const;
+
+private Q_SLOTS:
+    void onDispatchPendingCalls();
+
+private:
+    struct PendingCall {
+        QString method;
+        QByteArray payload;
+        ResponseHandler handler;
+        bool subscribe;
+    };
+
+    QHash<QString, Method> mMethods;
+    QHash<QString, QList<ResponseHandler> > mSubscriptions;
+    QList<PendingCall> mPendingCalls;
+    bool mStarted;
+    bool mDispatchScheduled;
+};
+
+} // namespace luna
+
+#endif // LOCALSERVICETRANSPORT_H
@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "logger.h"
+
+// Number of messages the ring buffer can hold; must be a power of two
+#define LOGGER_BUFFER_SIZE      1024
+// Maximum time the writer thread sleeps before checking the buffer again
+#define LOGGER_IDLE_TIMEOUT     50
+
+namespace luna
+{
+
+static qint64 monotonicTimestamp()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (qint64) ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+Logger* Logger::instance()
+{
+    static Logger* instance = 0;
+
+    if (!instance)
+        instance = new Logger();
+
+    return instance;
+}
+
+void Logger::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    Q_UNUSED(context);
+
+    Logger::instance()->log(type, msg);
+}
+
+Logger::Logger() :
+    mSlots(new Slot[LOGGER_BUFFER_SIZE]),
+    mMask(LOGGER_BUFFER_SIZE - 1),
+    mEnqueuePos(0),
+    mDequeuePos(0),
+    mRunning(true),
+    mThreadActive(false),
+    mSleeping(false),
+    mDropped(0),
+    mDroppedTotal(0)
+{
+    for (size_t n = 0; n < LOGGER_BUFFER_SIZE; n++)
+        mSlots[n].sequence.store(n, std::memory_order_relaxed);
+}
+
+Logger::~Logger()
+{
+    shutdown();
+    delete[] mSlots;
+}
+
+quint64 Logger::droppedMessages() const
+{
+    return mDroppedTotal.load(std::memory_order_relaxed);
+}
+
+void Logger::log(QtMsgType type, const QString &message)
+{
+    qint64 timestamp = monotonicTimestamp();
+
+    // Without the writer thread (not started yet or already shut down) we
+    // write synchronously so nothing gets lost
+    if (!mThreadActive.load(std::memory_order_acquire) || type == QtFatalMsg) {
+        flush();
+        write(type, timestamp, message);
+        return;
+    }
+
+    Slot *slot = 0;
+    size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+
+    for (;;) {
+        slot = &mSlots[pos & mMask];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+
+        if (diff == 0) {
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0) {
+            // buffer is full
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            mDroppedTotal.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        else {
+            pos = mEnqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    slot->type = type;
+    slot->timestamp = timestamp;
+    slot->message = message;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    if (mSleeping.load(std::memory_order_acquire)) {
+        mWakeLock.lock();
+        mWakeCondition.wakeOne();
+        mWakeLock.unlock();
+    }
+}
+
+bool Logger::drain()
+{
+    QMutexLocker locker(&mDrainLock);
+    bool drained = false;
+
+    for (;;) {
+        Slot &slot = mSlots[mDequeuePos & mMask];
+        size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+        if (sequence != mDequeuePos + 1)
+            break;
+
+        write(slot.type, slot.timestamp, slot.message);
+
+        slot.message = QString();
+        slot.sequence.store(mDequeuePos + mMask + 1, std::memory_order_release);
+        mDequeuePos++;
+        drained = true;
+    }
+
+    quint64 dropped = mDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+        write(QtWarningMsg, monotonicTimestamp(),
+              QString("Logger dropped %1 messages (%2 in total)").arg(dropped).arg(droppedMessages()));
+
+    return drained;
+}
+
+void Logger::flush()
+{
+    drain();
+    fflush(stderr);
+}
+
+void Logger::write(QtMsgType type, qint64 timestamp, const QString &message)
+{
+    const char *level;
+
+    switch (type) {
+    case QtDebugMsg:
+        level = "DEBUG";
+        break;
+    case QtWarningMsg:
+        level = "WARNING";
+        break;
+    case QtCriticalMsg:
+        level = "CRITICAL";
+        break;
+    case QtFatalMsg:
+        level = "FATAL";
+        break;
+    default:
+        level = "INFO";
+        break;
+    }
+
+    fprintf(stderr, "%s: [%lld.%06lld] %s\n", level,
+            timestamp / 1000000LL, timestamp % 1000000LL,
+            message.toUtf8().constData());
+}
+
+void Logger::run()
+{
+    mThreadActive.store(true, std::memory_order_release);
+
+    while (mRunning.load(std::memory_order_relaxed)) {
+        if (drain())
+            continue;
+
+        fflush(stderr);
+
+        mWakeLock.lock();
+        mSleeping.store(true, std::memory_order_release);
+        mWakeCondition.wait(&mWakeLock, LOGGER_IDLE_TIMEOUT);
+        mSleeping.store(false, std::memory_order_release);
+        mWakeLock.unlock();
+    }
+
+    mThreadActive.store(false, std::memory_order_release);
+
+    flush();
+}
+
+void Logger::shutdown()
+{
+    if (!isRunning())
+        return;
+
+    mRunning.store(false, std::memory_order_relaxed);
+
+    mWakeLock.lock();
+    mWakeCondition.wakeOne();
+    mWakeLock.unlock();
+
+    wait();
+}
+
+} // namespace luna
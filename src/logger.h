@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QString>
+
+#include <atomic>
+
+namespace luna
+{
+
+/*
+ * Asynchronous logger. Messages are put into a fixed size lock-free ring
+ * buffer by the logging thread and written out to stderr by a background
+ * thread. If the buffer is full the message is dropped and accounted so the
+ * caller never blocks on the output. Which messages reach the logger at all
+ * is decided by the logging categories (see logging.h).
+ */
+class Logger : public QThread
+{
+    Q_OBJECT
+
+public:
+    static Logger* instance();
+
+    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg);
+
+    void log(QtMsgType type, const QString &message);
+    void flush();
+    void shutdown();
+
+    quint64 droppedMessages() const;
+
+protected:
+    void run();
+
+private:
+    Logger();
+    ~Logger();
+
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        QtMsgType type;
+        qint64 timestamp;
+        QString message;
+    };
+
+    Slot *mSlots;
+    size_t mMask;
+    std::atomic<size_t> mEnqueuePos;
+    size_t mDequeuePos;
+
+    std::atomic<bool> mRunning;
+    std::atomic<bool> mThreadActive;
+    std::atomic<bool> mSleeping;
+    std::atomic<quint64> mDropped;
+    std::atomic<quint64> mDroppedTotal;
+
+    QMutex mDrainLock;
+    QMutex mWakeLock;
+    QWaitCondition mWakeCondition;
+
+    bool drain();
+    void write(QtMsgType type, qint64 timestamp, const QString &message);
+};
+
+} // namespace luna
+
+#endif // LOGGER_H
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QMap>
+#include <QSet>
+#include <QStringList>
+
+#include "logging.h"
+
+Q_LOGGING_CATEGORY(lcLaunch, "webappmgr.launch")
+Q_LOGGING_CATEGORY(lcWindow, "webappmgr.window")
+Q_LOGGING_CATEGORY(lcBridge, "webappmgr.bridge")
+Q_LOGGING_CATEGORY(lcExtensions, "webappmgr.extensions")
+Q_LOGGING_CATEGORY(lcService, "webappmgr.service")
+Q_LOGGING_CATEGORY(lcActivity, "webappmgr.activity")
+Q_LOGGING_CATEGORY(lcMemory, "webappmgr.memory")
+Q_LOGGING_CATEGORY(lcFrames, "webappmgr.frames")
+Q_LOGGING_CATEGORY(lcWatchdog, "webappmgr.watchdog")
+
+namespace luna
+{
+
+static bool sVerbose = false;
+static QMap<QString, QString> sCategoryLevels;
+static QSet<QString> sTracedApps;
+
+static const char* categoryNames[] = {
+    "launch", "window", "bridge", "extensions", "service", "activity", "memory", "frames", "watchdog", 0
+};
+
+static bool isKnownCategory(const QString &category)
+{
+    if (category == "*")
+        return true;
+
+    for (int n = 0; categoryNames[n]; n++) {
+        if (category == categoryNames[n])
+            return true;
+    }
+
+    return false;
+}
+
+static void applyFilterRules()
+{
+    QStringList rules;
+
+    // --verbose turns on debug output for everything, including messages
+    // logged through the default category
+    rules << QString("*.debug=%1").arg(sVerbose ? "true" : "false");
+
+    QMap<QString, QString>::const_iterator iter;
+    for (iter = sCategoryLevels.constBegin(); iter != sCategoryLevels.constEnd(); ++iter) {
+        QString pattern = iter.key() == "*" ? QString("webappmgr.*") :
+                                              QString("webappmgr.%1").arg(iter.key());
+        QString level = iter.value();
+
+        bool debug = (level == "debug");
+        bool warning = debug || (level == "warning");
+        bool critical = warning || (level == "critical");
+
+        rules << QString("%1.debug=%2").arg(pattern).arg(debug ? "true" : "false");
+        rules << QString("%1.warning=%2").arg(pattern).arg(warning ? "true" : "false");
+        rules << QString("%1.critical=%2").arg(pattern).arg(critical ? "true" : "false");
+    }
+
+    QLoggingCategory::setFilterRules(rules.join("\n"));
+}
+
+void initializeLogging(bool verbose)
+{
+    sVerbose = verbose;
+    applyFilterRules();
+}
+
+bool setLogLevel(const QString &category, const QString &level, const QString &appId)
+{
+    if (!isKnownCategory(category))
+        return false;
+
+    if (level != "debug" && level != "warning" && level != "critical" && level != "none")
+        return false;
+
+    // A single category reset to "*" makes all previous specific settings
+    // obsolete as later rules would override it otherwise
+    if (category == "*")
+        sCategoryLevels.clear();
+
+    sCategoryLevels.insert(category, level);
+
+    // A change without an application applies to everyone, so whatever
+    // was traced before must not limit or keep up the output anymore
+    if (appId.isEmpty())
+        sTracedApps.clear();
+    else if (level == "debug")
+        sTracedApps.insert(appId);
+    else
+        sTracedApps.remove(appId);
+
+    applyFilterRules();
+
+    return true;
+}
+
+bool isLoggingEnabledForApp(const QString &appId)
+{
+    return sTracedApps.isEmpty() || sTracedApps.contains(appId);
+}
+
+} // namespace luna
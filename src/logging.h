@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QLoggingCategory>
+#include <QString>
+
+Q_DECLARE_LOGGING_CATEGORY(lcLaunch)
+Q_DECLARE_LOGGING_CATEGORY(lcWindow)
+Q_DECLARE_LOGGING_CATEGORY(lcBridge)
+Q_DECLARE_LOGGING_CATEGORY(lcExtensions)
+Q_DECLARE_LOGGING_CATEGORY(lcService)
+Q_DECLARE_LOGGING_CATEGORY(lcActivity)
+Q_DECLARE_LOGGING_CATEGORY(lcMemory)
+Q_DECLARE_LOGGING_CATEGORY(lcFrames)
+Q_DECLARE_LOGGING_CATEGORY(lcWatchdog)
+
+/*
+ * Like qCDebug but additionally only logs when tracing is enabled for the
+ * given application (or no application filter is set at all).
+ */
+#define qCDebugForApp(category, appId) \
+    for (bool qt_category_enabled = category().isDebugEnabled() && luna::isLoggingEnabledForApp(appId); \
+         qt_category_enabled; qt_category_enabled = false) \
+        QMessageLogger(__FILE__, __LINE__, Q_FUNC_INFO, category().categoryName()).debug()
+
+namespace luna
+{
+
+void initializeLogging(bool verbose);
+
+bool setLogLevel(const QString &category, const QString &level, const QString &appId = QString());
+
+bool isLoggingEnabledForApp(const QString &appId);
+
+} // namespace luna
+
+#endif // LOGGING_H
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "lunaservicetransport.h"
+
+namespace luna
+{
+
+LunaServiceRequest::LunaServiceRequest(LSMessage *message) :
+    mMessage(message)
+{
+}
+
+QByteArray LunaServiceRequest::payload() const
+{
+    return QByteArray(mMessage.getPayload());
+}
+
+bool LunaServiceRequest::isSubscription() const
+{
+    return mMessage.isSubscription();
+}
+
+void LunaServiceRequest::respond(const QByteArray &response)
+{
+    mMessage.respond(response.constData());
+}
+
+LS::Message& LunaServiceRequest::message()
+{
+    return mMessage;
+}
+
+LunaServiceTransport::LunaServiceTransport(const char *serviceId) :
+    LS::Handle(LS::registerService(serviceId, false))
+{
+    attachToLoop(g_main_loop_new(g_main_context_default(), FALSE));
+}
+
+LunaServiceTransport::~LunaServiceTransport()
+{
+    qDeleteAll(mSubscriptions);
+}
+
+void LunaServiceTransport::registerMethod(const QString &name, const Method &method)
+{
+    mMethods.insert(name, method);
+}
+
+void LunaServiceTransport::start()
+{
+    // The method table has to stay alive as long as the category is
+    // registered so we keep it and the names it points to around
+    Q_FOREACH(const QString &name, mMethods.keys()) {
+        mMethodNames.append(name.toUtf8());
+
+        LSMethod method = { mMethodNames.last().constData(), &LunaServiceTransport::dispatch };
+        mMethodTable.append(method);
+    }
+
+    LSMethod terminator = { 0, 0 };
+    mMethodTable.append(terminator);
+
+    registerCategory("/", mMethodTable.data(), 0, 0);
+    setCategoryData("/", this);
+}
+
+bool LunaServiceTransport::dispatch(LSHandle *handle, LSMessage *message, void *data)
+{
+    Q_UNUSED(handle);
+
+    LunaServiceTransport *transport = static_cast<LunaServiceTransport*>(data);
+
+    Method method = transport->mMethods.value(QString(LSMessageGetMethod(message)));
+    if (!method)
+        return false;
+
+    LunaServiceRequest request(message);
+    return method(request);
+}
+
+void LunaServiceTransport::subscribe(const QString &key, ServiceRequest &request)
+{
+    LS::SubscriptionPoint *point = mSubscriptions.value(key);
+    if (!point) {
+        point = new LS::SubscriptionPoint;
+        point->setServiceHandle(this);
+        mSubscriptions.insert(key, point);
+    }
+
+    point->subscribe(static_cast<LunaServiceRequest&>(request).message());
+}
+
+void LunaServiceTransport::post(const QString &key, const QByteArray &payload)
+{
+    LS::SubscriptionPoint *point = mSubscriptions.value(key);
+    if (!point)
+        return;
+
+    point->post(payload.constData());
+}
+
+} // namespace luna
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef LUNASERVICETRANSPORT_H
+#define LUNASERVICETRANSPORT_H
+
+#include <QHash>
+#include <QList>
+#include <QVector>
+
+#include <glib.h>
+#include <luna-service2/lunaservice.hpp>
+
+#include "servicetransport.h"
+
+namespace luna
+{
+
+class LunaServiceRequest : public ServiceRequest
+{
+public:
+    LunaServiceRequest(LSMessage *message);
+
+    QByteArray payload() const;
+    bool isSubscription() const;
+    void respond(const QByteArray &response);
+
+    LS::Message& message();
+
+private:
+    mutable LS::Message mMessage;
+};
+
+class LunaServiceTransport : public ServiceTransport, private LS::Handle
+{
+public:
+    LunaServiceTransport(const char *serviceId);
+    ~LunaServiceTransport();
+
+    void registerMethod(const QString &name, const Method &method);
+    void start();
+
+    void subscribe(const QString &key, ServiceRequest &request);
+    void post(const QString &key, const QByteArray &payload);
+
+private:
+    static bool dispatch(LSHandle *handle, LSMessage *message, void *data);
+
+    QHash<QString, Method> mMethods;
+    QList<QByteArray> mMethodNames;
+    QVector<LSMethod> mMethodTable;
+    QHash<QString, LS::SubscriptionPoint*> mSubscriptions;
+};
+
+} // namespace luna
+
+#endif // LUNASERVICETRANSPORT_H
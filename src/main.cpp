@@ -17,16 +17,16 @@
 
 #include <QDebug>
 #include <QStringList>
-#include <QTime>
 #include <QtGlobal>
+#include <QCoreApplication>
 
 #include <glib.h>
-#include <systemd/sd-daemon.h>
-
-#include <LocalePreferences.h>
 
 #include "webappmanager.h"
-#include "systemtime.h"
+#include "logger.h"
+#include "logging.h"
+#include "startupprofiler.h"
+#include "qmlcache.h"
 
 #define VERSION "0.1"
 #define XDG_RUNTIME_DIR_DEFAULT "/tmp/luna-session"
@@ -34,46 +34,79 @@
 static gboolean option_version = FALSE;
 static gboolean option_verbose = FALSE;
 static gboolean option_systemd = FALSE;
+static gchar *option_record_traffic = NULL;
+static gint option_release_hidden_after = 10;
+static gboolean option_tombstone_evicted = FALSE;
+static gboolean option_share_gl_contexts = FALSE;
+static gint option_frame_statistics_interval = 0;
+static gint option_stall_threshold = 0;
+static gboolean option_show_on_first_paint = FALSE;
 
 static GOptionEntry options[] = {
     { "verbose", 0, 0, G_OPTION_ARG_NONE, &option_verbose, "Enable verbose logging" },
     { "version", 'v', 0, G_OPTION_ARG_NONE, &option_version,
         "Show version information and exit" },
     { "systemd", 0, 0, G_OPTION_ARG_NONE, &option_systemd, "Start with systemd support" },
+    { "record-traffic", 0, 0, G_OPTION_ARG_FILENAME, &option_record_traffic,
+        "Record all incoming service requests to the given file" },
+    { "release-hidden-after", 0, 0, G_OPTION_ARG_INT, &option_release_hidden_after,
+        "Release rendering resources of windows hidden for the given seconds, negative to never release them" },
+    { "tombstone-evicted", 0, 0, G_OPTION_ARG_NONE, &option_tombstone_evicted,
+        "Keep a placeholder card for applications closed because of low memory" },
+    { "share-gl-contexts", 0, 0, G_OPTION_ARG_NONE, &option_share_gl_contexts,
+        "Share OpenGL resources between all windows, with QSG_RENDER_LOOP=basic glyph caches and atlases too" },
+    { "frame-statistics-interval", 0, 0, G_OPTION_ARG_INT, &option_frame_statistics_interval,
+        "Log the frame statistics of all windows every given seconds" },
+    { "stall-threshold", 0, 0, G_OPTION_ARG_INT, &option_stall_threshold,
+        "Record event loop stalls longer than the given milliseconds, 0 to disable" },
+    { "show-on-first-paint", 0, 0, G_OPTION_ARG_NONE, &option_show_on_first_paint,
+        "Show windows as soon as their content is painted instead of waiting for their stage to be ready" },
     { NULL },
 };
 
-void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
-{
-    QString timeStr = QTime::currentTime().toString("hh:mm:ss.zzz");
-
-    switch(type)
-    {
-    case QtDebugMsg:
-        if (option_verbose)
-            fprintf(stderr, "DEBUG: %s: %s\n", timeStr.toUtf8().constData(), msg.toUtf8().constData());
-        break;
-    case QtWarningMsg:
-        fprintf(stderr, "WARNING: %s: %s\n", timeStr.toUtf8().constData(), msg.toUtf8().constData());
-        break;
-    case QtCriticalMsg:
-        fprintf(stderr, "CRITICAL: %s: %s\n", timeStr.toUtf8().constData(), msg.toUtf8().constData());
-        break;
-    case QtFatalMsg:
-        fprintf(stderr, "FATAL: %s: %s\n", timeStr.toUtf8().constData(), msg.toUtf8().constData());
-        break;
-    default:
-        fprintf(stderr, "INFO: %s: %s\n", timeStr.toUtf8().constData(), msg.toUtf8().constData());
-        break;
-    }
-}
-
 int main(int argc, char **argv)
 {
     GError *error = NULL;
     GOptionContext *context;
 
-    qInstallMessageHandler(messageHandler);
+    luna::StartupProfiler::instance();
+
+    luna::Logger::instance()->start();
+    qInstallMessageHandler(luna::Logger::messageHandler);
+    luna::initializeLogging(false);
+
+    context = g_option_context_new(NULL);
+    g_option_context_add_main_entries(context, options, NULL);
+
+    // Our options are needed before the application exists, Qt picks its
+    // own ones up when it's created
+    g_option_context_set_ignore_unknown_options(context, TRUE);
+
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        if (error) {
+            g_printerr("%s\n", error->message);
+            g_error_free(error);
+        }
+        else
+            g_printerr("An unknown error occurred\n");
+        exit(1);
+    }
+
+    g_option_context_free(context);
+
+    luna::initializeLogging(option_verbose);
+
+    if (option_version) {
+        g_message("LunaWebAppMgr %s", VERSION);
+        luna::Logger::instance()->shutdown();
+        return 0;
+    }
+
+    // All windows render with contexts from one share group so shaders and
+    // textures are only uploaded once. Has to be set before the application
+    // is created.
+    if (option_share_gl_contexts)
+        QCoreApplication::setAttribute(Qt::AA_ShareOpenGLContexts);
 
     if (qgetenv("DISPLAY").isEmpty()) {
         setenv("EGL_PLATFORM", "wayland", 0);
@@ -98,40 +131,32 @@ int main(int argc, char **argv)
         setenv("XDG_CACHE_HOME", cacheDir.toUtf8().constData(), 1);
     }
 
-    luna::WebAppManager webAppManager(argc, argv);
+    luna::QmlCache::instance()->setup();
 
-    context = g_option_context_new(NULL);
-    g_option_context_add_main_entries(context, options, NULL);
+    luna::StartupProfiler::instance()->mark("environment");
 
-    if (!g_option_context_parse(context, &argc, &argv, &error)) {
-        if (error) {
-            g_printerr("%s\n", error->message);
-            g_error_free(error);
-        }
-        else
-            g_printerr("An unknown error occurred\n");
-        exit(1);
-    }
-
-    g_option_context_free(context);
-
-    if (option_version) {
-        g_message("LunaWebAppMgr %s", VERSION);
-        goto cleanup;
-    }
+    luna::WebAppManager webAppManager(argc, argv);
 
     if (QFile::exists("/var/luna/dev-mode-enabled"))
         setenv("QTWEBKIT_INSPECTOR_SERVER", "1122", 0);
 
-    LocalePreferences::instance();
-    luna::SystemTime::instance();
+    webAppManager.setNotifySystemd(option_systemd);
+    webAppManager.setTombstoneEvicted(option_tombstone_evicted);
+    webAppManager.setStallThreshold(option_stall_threshold);
+    webAppManager.setFrameStatisticsInterval(option_frame_statistics_interval * 1000);
+    webAppManager.setShowOnFirstPaint(option_show_on_first_paint);
+    webAppManager.setResourceReleaseDelay(option_release_hidden_after < 0 ? -1 : option_release_hidden_after * 1000);
 
-    if (option_systemd)
-        sd_notify(0, "READY=1");
+    // Recording can also be enabled through the environment so it can be
+    // turned on for a device without touching the unit file
+    if (option_record_traffic)
+        webAppManager.setTrafficRecordFile(QString::fromUtf8(option_record_traffic));
+    else if (!qgetenv("WEBAPPMGR_RECORD_TRAFFIC").isEmpty())
+        webAppManager.setTrafficRecordFile(QString::fromUtf8(qgetenv("WEBAPPMGR_RECORD_TRAFFIC")));
 
     webAppManager.exec();
 
-cleanup:
+    luna::Logger::instance()->shutdown();
 
     return 0;
 }
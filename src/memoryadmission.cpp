@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QStringList>
+
+#include <algorithm>
+
+#include "memoryadmission.h"
+#include "applicationhistory.h"
+#include "windowpool.h"
+#include "webappmanager.h"
+#include "webapplication.h"
+#include "logging.h"
+#include "utils.h"
+
+// All sizes are in kB
+#define DEFAULT_CARD_ESTIMATE       (60 * 1024)
+#define DEFAULT_HEADLESS_ESTIMATE   (30 * 1024)
+#define MEMORY_RESERVE              (32 * 1024)
+#define TRIM_FACTOR                 10
+#define SAMPLE_INTERVAL             15000
+
+namespace luna
+{
+
+MemoryAdmission::MemoryAdmission(WebAppManager *manager) :
+    QObject(manager),
+    mManager(manager)
+{
+    mSampleTimer.setInterval(SAMPLE_INTERVAL);
+    connect(&mSampleTimer, SIGNAL(timeout()), this, SLOT(onSample()));
+}
+
+qint64 MemoryAdmission::estimate(WebApplication *app) const
+{
+    qint64 peak = ApplicationHistory::instance()->peakMemory(app->id());
+    if (peak > 0)
+        return peak;
+
+    return app->headless() ? DEFAULT_HEADLESS_ESTIMATE : DEFAULT_CARD_ESTIMATE;
+}
+
+qint64 MemoryAdmission::currentMemory(const QString &appId) const
+{
+    if (!mProcesses.contains(appId))
+        return 0;
+
+    return residentMemory(mProcesses.value(appId));
+}
+
+QList<WebApplication*> MemoryAdmission::reclaimCandidates(WebApplication *app) const
+{
+    QList<WebApplication*> candidates;
+
+    Q_FOREACH(WebApplication *candidate, mManager->applications()) {
+        if (candidate == app || !candidate->mainWindow() || candidate->launching())
+            continue;
+
+        // Whatever the user sees or the system depends on stays untouched
+        if (candidate->visible() || candidate->headless() || candidate->isLauncher() ||
+            candidate->id() == "com.palm.systemui" || candidate->mainWindow()->keepAlive())
+            continue;
+
+        candidates.append(candidate);
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](WebApplication *a, WebApplication *b) {
+        return a->lastActive() < b->lastActive();
+    });
+
+    return candidates;
+}
+
+void MemoryAdmission::admit(WebApplication *app)
+{
+    qint64 available = availableMemory();
+    if (available == 0)
+        return;
+
+    qint64 needed = estimate(app) + MEMORY_RESERVE;
+    if (needed <= available) {
+        qCDebug(lcMemory) << "Admitting" << app->id() << "with an estimate of" << needed
+                          << "kB," << available << "kB available";
+        return;
+    }
+
+    qint64 missing = needed - available;
+    qCDebug(lcMemory) << "Launch of" << app->id() << "needs" << missing << "kB more than available";
+
+    // Views kept around for reuse are the cheapest thing to give up
+    WindowPool::instance()->clear();
+
+    QList<WebApplication*> candidates = reclaimCandidates(app);
+
+    // Dropping caches is cheap and keeps the applications around, so do that
+    // for all of them before closing any
+    Q_FOREACH(WebApplication *candidate, candidates) {
+        qint64 expected = currentMemory(candidate->id()) / TRIM_FACTOR;
+        candidate->clearMemoryCaches();
+        missing -= expected;
+
+        qCDebug(lcMemory) << "Trimmed" << candidate->id() << "expecting to free" << expected << "kB";
+    }
+
+    QStringList toClose;
+    Q_FOREACH(WebApplication *candidate, candidates) {
+        if (missing <= 0)
+            break;
+
+        qint64 resident = currentMemory(candidate->id());
+        if (resident == 0)
+            resident = estimate(candidate);
+
+        qint64 expected = resident - resident / TRIM_FACTOR;
+        missing -= expected;
+        toClose.append(candidate->id());
+
+        qCDebug(lcMemory) << "Evicting least recently used" << candidate->id()
+                          << "expecting to free" << expected << "kB";
+    }
+
+    // Evicting deletes the applications so don't touch the candidates anymore
+    Q_FOREACH(const QString &appId, toClose)
+        mManager->evictApp(appId);
+
+    if (missing > 0)
+        qCWarning(lcMemory) << "Admitting" << app->id() << "although" << missing
+                            << "kB could not be reclaimed";
+    else
+        qCDebug(lcMemory) << "Admitting" << app->id() << "after reclaiming memory";
+}
+
+void MemoryAdmission::applicationLoaded(WebApplication *app)
+{
+    // Only the initial load happens in a fresh web process; reloads and
+    // navigations later on would pick up processes of other applications
+    if (mAttributed.contains(app->id()) || mProcesses.contains(app->id()))
+        return;
+
+    mAttributed.insert(app->id());
+
+    // There is no way to ask the web view for its process so we pick the one
+    // child process not belonging to any other application yet. When several
+    // pages finished loading at once this is ambiguous and we rather don't
+    // learn anything than attribute the memory to the wrong application.
+    QList<qint64> unassigned;
+    Q_FOREACH(qint64 pid, childProcesses()) {
+        if (!mProcesses.values().contains(pid))
+            unassigned.append(pid);
+    }
+
+    if (unassigned.size() != 1) {
+        qCDebug(lcMemory) << "Can't tell which of" << unassigned.size()
+                          << "unassigned web processes belongs to" << app->id();
+        return;
+    }
+
+    mProcesses.insert(app->id(), unassigned.first());
+    mSessionPeaks.insert(app->id(), residentMemory(unassigned.first()));
+
+    if (!mSampleTimer.isActive())
+        mSampleTimer.start();
+}
+
+void MemoryAdmission::applicationClosed(WebApplication *app)
+{
+    qint64 peak = mSessionPeaks.take(app->id());
+    if (peak > 0)
+        ApplicationHistory::instance()->recordMemory(app->id(), peak);
+
+    mProcesses.remove(app->id());
+    mAttributed.remove(app->id());
+
+    if (mProcesses.isEmpty())
+        mSampleTimer.stop();
+}
+
+void MemoryAdmission::onSample()
+{
+    QMap<QString, qint64>::const_iterator it;
+    for (it = mProcesses.constBegin(); it != mProcesses.constEnd(); ++it) {
+        qint64 resident = residentMemory(it.value());
+        if (resident > mSessionPeaks.value(it.key()))
+            mSessionPeaks.insert(it.key(), resident);
+    }
+}
+
+} // namespace luna
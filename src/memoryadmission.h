@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef MEMORYADMISSION_H
+#define MEMORYADMISSION_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+namespace luna
+{
+
+class WebAppManager;
+class WebApplication;
+
+/*
+ * Estimates what a launch will cost from the peak memory the application
+ * needed in previous runs and makes room before the window is constructed
+ * by trimming and, if that isn't enough, closing the least recently used
+ * background applications. The estimates are learned by sampling the
+ * resident memory of the web process belonging to each application.
+ */
+class MemoryAdmission : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MemoryAdmission(WebAppManager *manager);
+
+    void admit(WebApplication *app);
+
+    void applicationLoaded(WebApplication *app);
+    void applicationClosed(WebApplication *app);
+
+private Q_SLOTS:
+    void onSample();
+
+private:
+    WebAppManager *mManager;
+    QMap<QString, qint64> mProcesses;
+    QMap<QString, qint64> mSessionPeaks;
+    QSet<QString> mAttributed;
+    QTimer mSampleTimer;
+
+    qint64 estimate(WebApplication *app) const;
+    qint64 currentMemory(const QString &appId) const;
+    QList<WebApplication*> reclaimCandidates(WebApplication *app) const;
+};
+
+} // namespace luna
+
+#endif // MEMORYADMISSION_H
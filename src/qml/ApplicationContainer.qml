@@ -65,7 +65,8 @@ Flickable {
     }
 
     Component.onCompleted: {
-        if (webApp.isLauncher())
+        // Windows launched hidden get their web view once they're shown
+        if (webAppWindow.deferWebView)
             return;
 
         webViewLoader.sourceComponent = webViewComponent;
@@ -82,7 +83,7 @@ Flickable {
     Connections {
         target: webAppWindow
         onVisibleChanged: {
-            if (!webApp.isLauncher())
+            if (!webAppWindow.deferWebView)
                 return;
 
             if (!webAppWindow.visible)
@@ -130,17 +131,16 @@ Flickable {
 
             experimental.preferences.navigatorQtObjectEnabled: true
             experimental.preferences.localStorageEnabled: true
-            experimental.preferences.offlineWebApplicationCacheEnabled: true
-            experimental.preferences.webGLEnabled: true
-            experimental.preferences.developerExtrasEnabled: true
+            experimental.preferences.offlineWebApplicationCacheEnabled: webAppWindow.renderProfile.offlineCacheEnabled
+            experimental.preferences.webGLEnabled: webAppWindow.renderProfile.webGLEnabled
+            experimental.preferences.developerExtrasEnabled: webAppWindow.renderProfile.developerExtrasEnabled
 
             experimental.preferences.standardFontFamily: "Prelude"
             experimental.preferences.fixedFontFamily: "Courier new"
             experimental.preferences.serifFontFamily: "Times New Roman"
             experimental.preferences.cursiveFontFamily: "Prelude"
 
-            experimental.transparentBackground: (webAppWindow.windowType === "dashboard" ||
-                                                 webAppWindow.windowType === "popupalert")
+            experimental.transparentBackground: webAppWindow.renderProfile.transparentBackground
 
             experimental.databaseQuotaDialog: Item {
                 Component.onCompleted: {
@@ -241,7 +241,7 @@ Flickable {
                     experimental.preferences.logsPageMessagesToSystemConsole = true;
 
                 if (experimental.preferences.hasOwnProperty("suppressIncrementalRendering"))
-                    experimental.preferences.suppressIncrementalRendering = true;
+                    experimental.preferences.suppressIncrementalRendering = !webAppWindow.renderProfile.incrementalRendering;
             }
 
             experimental.onMessageReceived: {
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDir>
+#include <QQmlEngine>
+#include <QQmlComponent>
+#include <QUrl>
+
+#include "qmlcache.h"
+#include "utils.h"
+#include "logging.h"
+
+namespace luna
+{
+
+QmlCache* QmlCache::instance()
+{
+    static QmlCache* instance = 0;
+
+    if (!instance)
+        instance = new QmlCache();
+
+    return instance;
+}
+
+QmlCache::QmlCache() :
+    mNeedsWarmUp(false)
+{
+}
+
+QString QmlCache::path() const
+{
+    return mPath;
+}
+
+void QmlCache::setup()
+{
+    // Respect an explicit configuration from the environment (e.g. for
+    // debugging)
+    if (!qgetenv("QML_DISK_CACHE_PATH").isEmpty() || !qgetenv("QML_DISABLE_DISK_CACHE").isEmpty())
+        return;
+
+    QString cacheHome = qgetenv("XDG_CACHE_HOME");
+    if (cacheHome.isEmpty())
+        return;
+
+    QDir cacheRoot(QString("%1/LunaWebAppMgr/qmlcache").arg(cacheHome));
+    QString buildId = executableBuildId();
+
+    // Drop everything compiled by other builds
+    Q_FOREACH(QString entry, cacheRoot.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        if (entry == buildId)
+            continue;
+
+        qCDebug(lcLaunch) << "Removing stale QML cache" << entry;
+        QDir(cacheRoot.filePath(entry)).removeRecursively();
+    }
+
+    mPath = cacheRoot.filePath(buildId);
+
+    if (!QDir(mPath).exists()) {
+        if (!QDir().mkpath(mPath)) {
+            qWarning() << "Failed to create QML cache directory" << mPath;
+            mPath = QString();
+            return;
+        }
+
+        mNeedsWarmUp = true;
+    }
+
+    setenv("QML_DISK_CACHE_PATH", mPath.toUtf8().constData(), 1);
+}
+
+void QmlCache::warmUp()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+    if (!mNeedsWarmUp)
+        return;
+
+    mNeedsWarmUp = false;
+
+    qCDebug(lcLaunch) << "Populating QML cache" << mPath;
+
+    // Compiling the components is enough for the engine to store the
+    // results in the cache; nothing gets instantiated here
+    QQmlEngine engine;
+    QQmlComponent container(&engine, QUrl("qrc:///qml/ApplicationContainer.qml"));
+    QQmlComponent browser(&engine, QUrl("qrc:///qml/InAppBrowser.qml"));
+
+    if (container.isError())
+        qWarning() << "Failed to compile application container:" << container.errorString();
+    if (browser.isError())
+        qWarning() << "Failed to compile in app browser:" << browser.errorString();
+#endif
+}
+
+} // namespace luna
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef QMLCACHE_H
+#define QMLCACHE_H
+
+#include <QString>
+
+namespace luna
+{
+
+/*
+ * Persistent cache for the compiled QML and JavaScript of the application
+ * container. The cache lives below $XDG_CACHE_HOME in a directory named
+ * after the build id of the running binary so results compiled by a
+ * different build are never picked up.
+ */
+class QmlCache
+{
+public:
+    static QmlCache* instance();
+
+    void setup();
+    void warmUp();
+
+    QString path() const;
+
+private:
+    QmlCache();
+
+    QString mPath;
+    bool mNeedsWarmUp;
+};
+
+} // namespace luna
+
+#endif // QMLCACHE_H
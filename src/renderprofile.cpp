@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDebug>
+
+#include "renderprofile.h"
+
+namespace luna
+{
+
+struct ProfileSettings
+{
+    const char *name;
+    bool alphaBuffer;
+    bool transparentBackground;
+    bool incrementalRendering;
+    bool webGLEnabled;
+    bool offlineCacheEnabled;
+    bool developerExtrasEnabled;
+};
+
+// The first profile is the fallback for unknown names
+static const ProfileSettings profiles[] = {
+    // name          alpha  transp incr   webgl  cache  devel
+    { "card",        false, false, false, true,  true,  true  },
+    { "launcher",    true,  false, false, false, false, true  },
+    { "dashboard",   true,  true,  true,  false, false, false },
+    { "popupalert",  true,  true,  true,  false, false, false },
+    { "headless",    false, false, false, false, true,  true  },
+    { 0 }
+};
+
+static int findProfile(const QString &name)
+{
+    for (int n = 0; profiles[n].name; n++) {
+        if (name == profiles[n].name)
+            return n;
+    }
+
+    return -1;
+}
+
+RenderProfile::RenderProfile(const QString &name, QObject *parent) :
+    QObject(parent),
+    mIndex(findProfile(name))
+{
+    if (mIndex < 0) {
+        qWarning() << "Unknown render profile" << name << "using" << profiles[0].name << "instead";
+        mIndex = 0;
+    }
+}
+
+bool RenderProfile::exists(const QString &name)
+{
+    return findProfile(name) >= 0;
+}
+
+QString RenderProfile::name() const
+{
+    return profiles[mIndex].name;
+}
+
+bool RenderProfile::alphaBuffer() const
+{
+    return profiles[mIndex].alphaBuffer;
+}
+
+bool RenderProfile::transparentBackground() const
+{
+    return profiles[mIndex].transparentBackground;
+}
+
+bool RenderProfile::incrementalRendering() const
+{
+    return profiles[mIndex].incrementalRendering;
+}
+
+bool RenderProfile::webGLEnabled() const
+{
+    return profiles[mIndex].webGLEnabled;
+}
+
+bool RenderProfile::offlineCacheEnabled() const
+{
+    return profiles[mIndex].offlineCacheEnabled;
+}
+
+bool RenderProfile::developerExtrasEnabled() const
+{
+    return profiles[mIndex].developerExtrasEnabled;
+}
+
+} // namespace luna
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef RENDERPROFILE_H
+#define RENDERPROFILE_H
+
+#include <QObject>
+#include <QString>
+
+namespace luna
+{
+
+/*
+ * Named set of rendering settings for a window. Each window type has its
+ * own profile so opaque cards skip alpha blending and light windows like
+ * dashboards drop web features they have no use for. Applications may
+ * pick a different profile for their main window in their description.
+ */
+class RenderProfile : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString name READ name CONSTANT)
+    Q_PROPERTY(bool alphaBuffer READ alphaBuffer CONSTANT)
+    Q_PROPERTY(bool transparentBackground READ transparentBackground CONSTANT)
+    Q_PROPERTY(bool incrementalRendering READ incrementalRendering CONSTANT)
+    Q_PROPERTY(bool webGLEnabled READ webGLEnabled CONSTANT)
+    Q_PROPERTY(bool offlineCacheEnabled READ offlineCacheEnabled CONSTANT)
+    Q_PROPERTY(bool developerExtrasEnabled READ developerExtrasEnabled CONSTANT)
+
+public:
+    explicit RenderProfile(const QString &name, QObject *parent = 0);
+
+    static bool exists(const QString &name);
+
+    QString name() const;
+    bool alphaBuffer() const;
+    bool transparentBackground() const;
+    bool incrementalRendering() const;
+    bool webGLEnabled() const;
+    bool offlineCacheEnabled() const;
+    bool developerExtrasEnabled() const;
+
+private:
+    int mIndex;
+};
+
+} // namespace luna
+
+#endif // RENDERPROFILE_H
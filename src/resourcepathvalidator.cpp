@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "resourcepathvalidator.h"
+
+namespace luna
+{
+
+ResourcePathValidator& ResourcePathValidator::instance()
+{
+    static ResourcePathValidator instance;
+    return instance;
+}
+
+ResourcePathValidator::ResourcePathValidator()
+{
+    // NOTE: below set of paths are taken from the configuration set in the webkit used in
+    // webOS 3.0.5. See http://downloads.help.palm.com/opensource/3.0.5/webcore-patch.gz
+
+    // paths allowed for every app
+    mAllowedTargetPaths << "/usr/palm/frameworks";
+    mAllowedTargetPaths << "/media/internal";
+    mAllowedTargetPaths << "/usr/lib/luna/luna-media";
+    mAllowedTargetPaths << "/var/luna/files";
+    mAllowedTargetPaths << "/var/luna/data/extractfs";
+    mAllowedTargetPaths << "/var/luna/data/im-avatars";
+    mAllowedTargetPaths <<  "/usr/palm/applications/com.palm.app.contacts/sharedWidgets/";
+    mAllowedTargetPaths << "/usr/palm/sysmgr/";
+    mAllowedTargetPaths << "/usr/palm/public";
+    mAllowedTargetPaths << "/var/file-cache/";
+    mAllowedTargetPaths << "/usr/lib/luna/system/luna-systemui/images/";
+    mAllowedTargetPaths << "/usr/lib/luna/system/luna-systemui/app/FilePicker";
+
+    // paths only allowed for privileged apps
+    mPrivilegedAppPaths << "/usr/lib/luna/system/";   // system ui apps
+    mPrivilegedAppPaths << "/usr/palm/applications/";  // Palm apps
+    mPrivilegedAppPaths << "/var/usr/palm/applications/com.palm.";  // privileged apps like facebook
+    mPrivilegedAppPaths << "/media/cryptofs/apps/usr/palm/applications/com.palm.";  // privileged 3rd party apps
+    mPrivilegedAppPaths << "/usr/palm/sysmgr/";
+    mPrivilegedAppPaths << "/var/usr/palm/applications/com/palm/";
+    mPrivilegedAppPaths << "/media/cryptofs/apps/usr/palm/applications/com/palm/";
+
+    // additional paths allowed for unprivileged apps
+    mUnprivilegedAppPaths << "/var/usr/palm/applications/";
+    mUnprivilegedAppPaths << "/media/cryptofs/apps/usr/palm/applications/";
+}
+
+bool ResourcePathValidator::validate(const QString &path, bool privileged)
+{
+    if (findPathInList(mAllowedTargetPaths, path))
+        return true;
+    if (privileged && findPathInList(mPrivilegedAppPaths, path))
+        return true;
+    if (!privileged && findPathInList(mUnprivilegedAppPaths, path))
+        return true;
+
+    return false;
+}
+
+bool ResourcePathValidator::findPathInList(const QStringList &list, const QString &path)
+{
+    Q_FOREACH(const QString &item, list) {
+        if (path.startsWith(item))
+            return true;
+    }
+    return false;
+}
+
+} // namespace luna
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDateTime>
+#include <QJsonDocument>
+
+#include "servicerecorder.h"
+#include "logging.h"
+
+#define SERVICE_RECORDER_HEADER     "# webappmanager traffic v1"
+
+namespace luna
+{
+
+ServiceRecorder::ServiceRecorder()
+{
+}
+
+ServiceRecorder::~ServiceRecorder()
+{
+    stop();
+}
+
+bool ServiceRecorder::start(const QString &path)
+{
+    stop();
+
+    mFile.setFileName(path);
+    if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Failed to open" << path << "for recording service traffic";
+        return false;
+    }
+
+    mFile.write(QString("%1 %2\n").arg(SERVICE_RECORDER_HEADER)
+                .arg(QDateTime::currentDateTimeUtc().toString(Qt::ISODate)).toUtf8());
+    mFile.flush();
+
+    mTimer.start();
+
+    qCDebug(lcService) << "Recording service traffic to" << path;
+
+    return true;
+}
+
+void ServiceRecorder::stop()
+{
+    if (mFile.isOpen())
+        mFile.close();
+}
+
+bool ServiceRecorder::isRecording() const
+{
+    return mFile.isOpen();
+}
+
+qint64 ServiceRecorder::elapsed() const
+{
+    return mTimer.nsecsElapsed() / 1000;
+}
+
+void ServiceRecorder::record(const QString &method, bool subscription, const QByteArray &payload,
+                             qint64 arrival, qint64 latency)
+{
+    if (!mFile.isOpen())
+        return;
+
+    // Keep one request per line no matter how the caller formatted it
+    QJsonDocument document = QJsonDocument::fromJson(payload);
+    QByteArray compactPayload = document.isNull() ? payload.simplified() :
+                                                    document.toJson(QJsonDocument::Compact);
+
+    QByteArray line;
+    line.append(QByteArray::number(arrival)).append('\t')
+        .append(method.toUtf8()).append('\t')
+        .append(subscription ? 's' : '-').append('\t')
+        .append(QByteArray::number(latency)).append('\t')
+        .append(compactPayload).append('\n');
+
+    // Service traffic is rare enough to afford writing it out right away
+    // which keeps the log usable when we crash
+    mFile.write(line);
+    mFile.flush();
+}
+
+QList<ServiceRecorder::Entry> ServiceRecorder::readLog(const QString &path)
+{
+    QList<Entry> entries;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return entries;
+
+    while (!file.atEnd()) {
+        QByteArray line = file.readLine();
+        if (line.startsWith('#'))
+            continue;
+
+        QList<QByteArray> fields = line.trimmed().split('\t');
+        if (fields.size() < 4)
+            continue;
+
+        Entry entry;
+        entry.arrival = fields.at(0).toLongLong();
+        entry.method = QString(fields.at(1));
+        entry.subscription = fields.at(2) == "s";
+        entry.latency = fields.at(3).toLongLong();
+        entry.payload = fields.size() > 4 ? fields.at(4) : QByteArray();
+
+        entries.append(entry);
+    }
+
+    return entries;
+}
+
+} // namespace luna
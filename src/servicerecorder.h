@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SERVICERECORDER_H
+#define SERVICERECORDER_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QString>
+
+namespace luna
+{
+
+/*
+ * Writes every incoming service request to a compact line based log. Each
+ * line holds the arrival time relative to the start of the recording, the
+ * method, whether it was a subscription, the time it took to handle the
+ * request and the compacted payload, all separated by tabs. Times are in
+ * microseconds.
+ */
+class ServiceRecorder
+{
+public:
+    struct Entry {
+        qint64 arrival;
+        QString method;
+        bool subscription;
+        qint64 latency;
+        QByteArray payload;
+    };
+
+    ServiceRecorder();
+    ~ServiceRecorder();
+
+    bool start(const QString &path);
+    void stop();
+    bool isRecording() const;
+
+    qint64 elapsed() const;
+    void record(const QString &method, bool subscription, const QByteArray &payload,
+                qint64 arrival, qint64 latency);
+
+    static QList<Entry> readLog(const QString &path);
+
+private:
+    QFile mFile;
+    QElapsedTimer mTimer;
+};
+
+} // namespace luna
+
+#endif // SERVICERECORDER_H
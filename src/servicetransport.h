@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef SERVICETRANSPORT_H
+#define SERVICETRANSPORT_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <functional>
+
+namespace luna
+{
+
+class ServiceRequest
+{
+public:
+    virtual ~ServiceRequest() { }
+
+    virtual QByteArray payload() const = 0;
+    virtual bool isSubscription() const = 0;
+    virtual void respond(const QByteArray &response) = 0;
+};
+
+/*
+ * Carries the calls for the service methods. Normally this is the bus but it
+ * can be replaced with an in-process implementation to drive the manager
+ * without a running hub.
+ */
+class ServiceTransport
+{
+public:
+    typedef std::function<bool(ServiceRequest&)> Method;
+
+    virtual ~ServiceTransport() { }
+
+    virtual void registerMethod(const QString &name, const Method &method) = 0;
+    virtual void start() = 0;
+
+    virtual void subscribe(const QString &key, ServiceRequest &request) = 0;
+    virtual void post(const QString &key, const QByteArray &payload) = 0;
+};
+
+} // namespace luna
+
+#endif // SERVICETRANSPORT_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QStringList>
+
+#include "startupprofiler.h"
+#include "logging.h"
+
+namespace luna
+{
+
+StartupProfiler* StartupProfiler::instance()
+{
+    static StartupProfiler* instance = 0;
+
+    if (!instance)
+        instance = new StartupProfiler();
+
+    return instance;
+}
+
+StartupProfiler::StartupProfiler() :
+    mLastMark(0)
+{
+    mTimer.start();
+}
+
+void StartupProfiler::mark(const QString &phase)
+{
+    qint64 now = mTimer.elapsed();
+
+    mPhases.append(QPair<QString, qint64>(phase, now - mLastMark));
+    mLastMark = now;
+
+    qCDebug(lcLaunch) << "Startup phase" << phase << "took" << mPhases.last().second << "ms";
+}
+
+qint64 StartupProfiler::elapsed() const
+{
+    return mTimer.elapsed();
+}
+
+QString StartupProfiler::summary() const
+{
+    QStringList phases;
+
+    for (int n = 0; n < mPhases.count(); n++)
+        phases << QString("%1 %2ms").arg(mPhases.at(n).first).arg(mPhases.at(n).second);
+
+    return QString("Started in %1ms (%2)").arg(mLastMark).arg(phases.join(", "));
+}
+
+} // namespace luna
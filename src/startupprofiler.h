@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+namespace luna
+{
+
+class StartupProfiler
+{
+public:
+    static StartupProfiler* instance();
+
+    void mark(const QString &phase);
+
+    qint64 elapsed() const;
+    QString summary() const;
+
+private:
+    StartupProfiler();
+
+    QElapsedTimer mTimer;
+    qint64 mLastMark;
+    QList<QPair<QString, qint64> > mPhases;
+};
+
+} // namespace luna
+
+#endif // STARTUPPROFILER_H
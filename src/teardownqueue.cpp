@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDebug>
+
+#include "teardownqueue.h"
+#include "webapplication.h"
+#include "webapplicationwindow.h"
+#include "watchdog.h"
+#include "logging.h"
+
+namespace luna
+{
+
+TeardownQueue::TeardownQueue(QObject *parent) :
+    QObject(parent)
+{
+    // A zero timer fires once all pending events are handled, so input and
+    // rendering of the remaining windows always go first
+    mStepTimer.setSingleShot(true);
+    mStepTimer.setInterval(0);
+    connect(&mStepTimer, SIGNAL(timeout()), this, SLOT(onProcessStep()));
+}
+
+TeardownQueue::~TeardownQueue()
+{
+    flush();
+}
+
+void TeardownQueue::schedule(WebApplication *app)
+{
+    QString appId = app->id();
+
+    // Nothing of the application may be seen anymore while it's taken apart
+    app->hide();
+
+    QList<WebApplicationWindow*> windows = app->takeWindows();
+
+    qCDebug(lcLaunch) << "Scheduling teardown of" << appId << "with" << windows.count() << "windows";
+
+    // Taking the content down ends the web process which is the most
+    // expensive part, so every window gets its own step for it
+    Q_FOREACH(WebApplicationWindow *window, windows)
+        addStep(appId, [window]() { window->releaseWebView(); });
+
+    // Extensions, plugin and the view going back to the pool
+    Q_FOREACH(WebApplicationWindow *window, windows)
+        addStep(appId, [window]() { delete window; });
+
+    // The activity and with it the last bus handles of the application
+    addStep(appId, [app]() { delete app; });
+}
+
+void TeardownQueue::flush()
+{
+    while (!mSteps.isEmpty()) {
+        Step step = mSteps.takeFirst();
+        step.run();
+    }
+
+    mStepTimer.stop();
+}
+
+int TeardownQueue::pending() const
+{
+    return mSteps.size();
+}
+
+void TeardownQueue::addStep(const QString &appId, const std::function<void()> &run)
+{
+    Step step;
+    step.appId = appId;
+    step.run = run;
+    mSteps.append(step);
+
+    if (!mStepTimer.isActive())
+        mStepTimer.start();
+}
+
+void TeardownQueue::onProcessStep()
+{
+    if (mSteps.isEmpty())
+        return;
+
+    Step step = mSteps.takeFirst();
+
+    {
+        Watchdog::Scope watchdog("teardown", step.appId);
+        step.run();
+    }
+
+    if (mSteps.isEmpty()) {
+        qCDebug(lcLaunch) << "Teardown of closed applications finished";
+        return;
+    }
+
+    mStepTimer.start();
+}
+
+} // namespace luna
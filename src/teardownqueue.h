@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef TEARDOWNQUEUE_H
+#define TEARDOWNQUEUE_H
+
+#include <QObject>
+#include <QList>
+#include <QString>
+#include <QTimer>
+
+#include <functional>
+
+namespace luna
+{
+
+class WebApplication;
+
+/*
+ * Takes closed applications apart over several event loop iterations.
+ * Their windows are hidden right away; the web views, the windows with
+ * their extensions and views and finally the application with its bus
+ * handles are released one step at a time so closing applications doesn't
+ * block whatever the user does next.
+ */
+class TeardownQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TeardownQueue(QObject *parent = 0);
+    ~TeardownQueue();
+
+    void schedule(WebApplication *app);
+    void flush();
+
+    int pending() const;
+
+private Q_SLOTS:
+    void onProcessStep();
+
+private:
+    struct Step {
+        QString appId;
+        std::function<void()> run;
+    };
+
+    QList<Step> mSteps;
+    QTimer mStepTimer;
+
+    void addStep(const QString &appId, const std::function<void()> &run);
+};
+
+} // namespace luna
+
+#endif // TEARDOWNQUEUE_H
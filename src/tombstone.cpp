@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDebug>
+#include <QFile>
+#include <QQmlContext>
+#include <QQuickView>
+#include <QtWebKit/private/qquickwebview_p.h>
+
+#include "tombstone.h"
+#include "webapplication.h"
+#include "webapplicationwindow.h"
+#include "logging.h"
+
+namespace luna
+{
+
+Tombstone::Tombstone(WebApplication *app, QObject *parent) :
+    QObject(parent),
+    mDescription(app->desc()),
+    mProcessId(app->processId()),
+    mUrl(app->url()),
+    mWindowType("card"),
+    mParameters(app->parameters()),
+    mRestoring(false),
+    mView(0)
+{
+    WebApplicationWindow *window = app->mainWindow();
+    if (!window)
+        return;
+
+    // Come back to where the user left, not to the entry point
+    if (window->webView() && window->webView()->url().isValid())
+        mUrl = window->webView()->url();
+
+    mWindowType = window->windowType();
+    mSize = window->size();
+
+    mSnapshotPath = WebApplicationWindow::snapshotPath(QString("%1-tombstone").arg(app->id()));
+    if (!window->saveSnapshot(mSnapshotPath))
+        mSnapshotPath.clear();
+}
+
+Tombstone::~Tombstone()
+{
+    delete mView;
+
+    if (!mSnapshotPath.isEmpty())
+        QFile::remove(mSnapshotPath);
+}
+
+void Tombstone::show()
+{
+    if (mView)
+        return;
+
+    qCDebug(lcMemory) << "Showing tombstone of" << appId() << "for" << mUrl;
+
+    mView = new QQuickView;
+    mView->installEventFilter(this);
+    mView->setColor(Qt::transparent);
+    mView->setResizeMode(QQuickView::SizeRootObjectToView);
+    mView->rootContext()->setContextProperty("snapshot",
+        mSnapshotPath.isEmpty() ? QUrl() : QUrl::fromLocalFile(mSnapshotPath));
+
+    // Look just like the card we replace so the compositor treats us the same
+    mProperties.setWindow(mView);
+    mProperties.setProperty(QString("_LUNE_WINDOW_TYPE"), QVariant(mWindowType));
+    mProperties.setProperty(QString("_LUNE_WINDOW_LOADING_ANIMATION_DISABLED"), QVariant(true));
+    mProperties.setProperty(QString("_LUNE_APP_ICON"), QVariant(mDescription.icon()));
+    mProperties.setProperty(QString("_LUNE_APP_ID"), QVariant(appId()));
+
+    mView->create();
+    mProperties.flush();
+
+    mView->setSource(QUrl(QString("qrc:///qml/Tombstone.qml")));
+    mView->resize(mSize);
+
+    mView->show();
+}
+
+bool Tombstone::eventFilter(QObject *object, QEvent *event)
+{
+    if (object == mView) {
+        switch (event->type()) {
+        case QEvent::Close:
+            emit closed();
+            break;
+        case QEvent::FocusIn:
+            emit activated();
+            break;
+        default:
+            break;
+        }
+    }
+
+    return false;
+}
+
+QString Tombstone::appId() const
+{
+    return mDescription.id();
+}
+
+int64_t Tombstone::processId() const
+{
+    return mProcessId;
+}
+
+QUrl Tombstone::url() const
+{
+    return mUrl;
+}
+
+QString Tombstone::windowType() const
+{
+    return mWindowType;
+}
+
+QString Tombstone::parameters() const
+{
+    return mParameters;
+}
+
+ApplicationDescription Tombstone::desc() const
+{
+    return mDescription;
+}
+
+bool Tombstone::restoring() const
+{
+    return mRestoring;
+}
+
+void Tombstone::setRestoring(bool restoring)
+{
+    mRestoring = restoring;
+}
+
+} // namespace luna
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef TOMBSTONE_H
+#define TOMBSTONE_H
+
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QUrl>
+
+#include "applicationdescription.h"
+#include "windowproperties.h"
+
+class QQuickView;
+
+namespace luna
+{
+
+class WebApplication;
+
+/*
+ * What is left of an application evicted to save memory: everything needed
+ * to launch it again where it was and a placeholder window showing a
+ * snapshot of its last content, so it stays in the card switcher.
+ */
+class Tombstone : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Tombstone(WebApplication *app, QObject *parent = 0);
+    ~Tombstone();
+
+    QString appId() const;
+    int64_t processId() const;
+    QUrl url() const;
+    QString windowType() const;
+    QString parameters() const;
+    ApplicationDescription desc() const;
+
+    bool restoring() const;
+    void setRestoring(bool restoring);
+
+    void show();
+
+Q_SIGNALS:
+    void activated();
+    void closed();
+
+protected:
+    bool eventFilter(QObject *object, QEvent *event);
+
+private:
+    ApplicationDescription mDescription;
+    int64_t mProcessId;
+    QUrl mUrl;
+    QString mWindowType;
+    QString mParameters;
+    QSize mSize;
+    QString mSnapshotPath;
+    bool mRestoring;
+    QQuickView *mView;
+    WindowProperties mProperties;
+
+};
+
+} // namespace luna
+
+#endif // TOMBSTONE_H
@@ -18,6 +18,16 @@
 #include <QString>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QJsonArray>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+
+#include <elf.h>
+#include <link.h>
+#include <string.h>
+#include <unistd.h>
 
 QString jsonObjectToString(const QJsonObject &object)
 {
@@ -25,3 +35,143 @@ QString jsonObjectToString(const QJsonObject &object)
     doc.setObject(object);
     return QString(doc.toJson());
 }
+
+bool parseSyncExtensionCall(const QVariantMap &message, QString &extension,
+                            QString &func, QJsonArray &params)
+{
+    if (!message.contains("data"))
+        return false;
+
+    QString data = message.value("data").toString();
+
+    QJsonDocument document = QJsonDocument::fromJson(data.toUtf8());
+
+    if (!document.isObject())
+        return false;
+
+    QJsonObject rootObject = document.object();
+
+    if (!rootObject.contains("messageType") || !rootObject.value("messageType").isString())
+        return false;
+
+    if (rootObject.value("messageType").toString() != "callSyncExtensionFunction")
+        return false;
+
+    if (!(rootObject.contains("extension") && rootObject.value("extension").isString()) ||
+        !(rootObject.contains("func") && rootObject.value("func").isString()) ||
+        !(rootObject.contains("params") && rootObject.value("params").isArray()))
+        return false;
+
+    extension = rootObject.value("extension").toString();
+    func = rootObject.value("func").toString();
+    params = rootObject.value("params").toArray();
+
+    return true;
+}
+
+static int findBuildIdNote(struct dl_phdr_info *info, size_t size, void *data)
+{
+    Q_UNUSED(size);
+
+    // The main executable is always reported first; we don't care about
+    // any of the shared objects so stop iterating after it
+    for (int n = 0; n < info->dlpi_phnum; n++) {
+        const ElfW(Phdr) &phdr = info->dlpi_phdr[n];
+        if (phdr.p_type != PT_NOTE)
+            continue;
+
+        const char *notes = reinterpret_cast<const char*>(info->dlpi_addr + phdr.p_vaddr);
+        size_t offset = 0;
+
+        while (offset + sizeof(ElfW(Nhdr)) <= phdr.p_memsz) {
+            const ElfW(Nhdr) *note = reinterpret_cast<const ElfW(Nhdr)*>(notes + offset);
+            const char *name = notes + offset + sizeof(ElfW(Nhdr));
+            size_t nameSize = (note->n_namesz + 3) & ~3;
+            size_t descSize = (note->n_descsz + 3) & ~3;
+
+            if (note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 &&
+                memcmp(name, "GNU", 4) == 0) {
+                QByteArray *buildId = static_cast<QByteArray*>(data);
+                *buildId = QByteArray(name + nameSize, note->n_descsz).toHex();
+                return 1;
+            }
+
+            offset += sizeof(ElfW(Nhdr)) + nameSize + descSize;
+        }
+    }
+
+    return 1;
+}
+
+QString executableBuildId()
+{
+    static QString buildId;
+
+    if (!buildId.isEmpty())
+        return buildId;
+
+    QByteArray note;
+    dl_iterate_phdr(findBuildIdNote, &note);
+
+    if (!note.isEmpty()) {
+        buildId = QString(note);
+    }
+    else {
+        // Linked without a build id note so fall back to something which
+        // changes with every new binary at least
+        QFileInfo executable("/proc/self/exe");
+        executable.setCaching(false);
+        QFileInfo target(executable.symLinkTarget());
+        buildId = QString("%1-%2").arg(target.size()).arg(target.lastModified().toTime_t());
+    }
+
+    return buildId;
+}
+
+static qint64 readProcValue(const QString &path, const char *key)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    Q_FOREACH(const QByteArray &line, file.readAll().split('\n')) {
+        if (line.startsWith(key))
+            return line.mid(qstrlen(key)).trimmed().split(' ').first().toLongLong();
+    }
+
+    return 0;
+}
+
+// All values are in kB as reported by the kernel; zero means unknown
+qint64 availableMemory()
+{
+    return readProcValue("/proc/meminfo", "MemAvailable:");
+}
+
+qint64 residentMemory(qint64 pid)
+{
+    return readProcValue(QString("/proc/%1/status").arg(pid), "VmRSS:");
+}
+
+// The web processes are spawned as direct children of ours
+QList<qint64> childProcesses()
+{
+    QList<qint64> children;
+    QByteArray self = QByteArray::number(getpid());
+
+    Q_FOREACH(const QString &pid, QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        QFile stat(QString("/proc/%1/stat").arg(pid));
+        if (!stat.open(QIODevice::ReadOnly))
+            continue;
+
+        // The command name may contain spaces so skip past it first
+        QByteArray data = stat.readAll();
+        QList<QByteArray> fields = data.mid(data.lastIndexOf(')') + 2).split(' ');
+        if (fields.size() < 2 || fields.at(1) != self)
+            continue;
+
+        children.append(pid.toLongLong());
+    }
+
+    return children;
+}
@@ -18,9 +18,22 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <QVariantMap>
+#include <QList>
+
 class QString;
 class QJsonObject;
+class QJsonArray;
 
 QString jsonObjectToString(const QJsonObject &object);
 
+bool parseSyncExtensionCall(const QVariantMap &message, QString &extension,
+                            QString &func, QJsonArray &params);
+
+QString executableBuildId();
+
+qint64 availableMemory();
+qint64 residentMemory(qint64 pid);
+QList<qint64> childProcesses();
+
 #endif // UTILS_H
@@ -0,0 +1,330 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QJsonArray>
+#include <QMutexLocker>
+
+#include <execinfo.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <systemd/sd-daemon.h>
+
+#include "watchdog.h"
+#include "logging.h"
+
+// All times in ms
+#define PING_INTERVAL       100
+#define CHECK_INTERVAL      20
+#define BACKTRACE_TIMEOUT   100
+#define MAX_BACKTRACE_DEPTH 64
+#define MAX_RECENT_STALLS   20
+
+namespace luna
+{
+
+// Set while the watchdog runs so scopes cost nothing otherwise
+static QAtomicInt sEnabled;
+
+static QAtomicPointer<const char> sEventClass;
+static QAtomicInt sEventType;
+
+// Filled by the GUI thread from within the signal handler
+static void *sBacktrace[MAX_BACKTRACE_DEPTH];
+static volatile sig_atomic_t sBacktraceDepth = -1;
+
+static void onBacktraceSignal(int)
+{
+    sBacktraceDepth = backtrace(sBacktrace, MAX_BACKTRACE_DEPTH);
+}
+
+static qint64 now()
+{
+    static QElapsedTimer timer;
+
+    if (!timer.isValid())
+        timer.start();
+
+    return timer.elapsed();
+}
+
+Watchdog::Scope::Scope(const char *kind, const char *label) :
+    mActive(sEnabled.load())
+{
+    if (!mActive)
+        return;
+
+    Source source;
+    source.kind = kind;
+    source.label = label;
+    enter(source);
+}
+
+Watchdog::Scope::Scope(const char *kind, const QString &name, const QString &detail) :
+    mActive(sEnabled.load())
+{
+    if (!mActive)
+        return;
+
+    Source source;
+    source.kind = kind;
+    source.name = name;
+    source.detail = detail;
+    enter(source);
+}
+
+Watchdog::Scope::~Scope()
+{
+    if (!mActive)
+        return;
+
+    Watchdog *watchdog = Watchdog::instance();
+
+    QMutexLocker locker(&watchdog->mSourceLock);
+    watchdog->mSource = mPrevious;
+}
+
+void Watchdog::Scope::enter(const Source &source)
+{
+    Watchdog *watchdog = Watchdog::instance();
+
+    QMutexLocker locker(&watchdog->mSourceLock);
+    mPrevious = watchdog->mSource;
+    watchdog->mSource = source;
+}
+
+Watchdog::EventScope::EventScope(QObject *receiver, QEvent *event) :
+    mPreviousClass(sEventClass.load()),
+    mPreviousType(sEventType.load())
+{
+    sEventClass.store(receiver->metaObject()->className());
+    sEventType.store(event->type());
+}
+
+Watchdog::EventScope::~EventScope()
+{
+    sEventClass.store(mPreviousClass);
+    sEventType.store(mPreviousType);
+}
+
+Watchdog* Watchdog::instance()
+{
+    static Watchdog* instance = 0;
+
+    if (!instance)
+        instance = new Watchdog();
+
+    return instance;
+}
+
+Watchdog::Watchdog() :
+    mThreshold(0),
+    mSystemdInterval(0),
+    mGuiThread(pthread_self()),
+    mStopping(0),
+    mAnswered(0),
+    mStallCount(0)
+{
+}
+
+void Watchdog::enable(int threshold, quint64 systemdInterval)
+{
+    if (isRunning())
+        return;
+
+    mThreshold = threshold;
+    mSystemdInterval = systemdInterval;
+    mGuiThread = pthread_self();
+    mStopping.store(0);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onBacktraceSignal;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR2, &action, 0);
+
+    // The first call loads the unwinder which must not happen in the
+    // signal handler
+    void *frames[1];
+    backtrace(frames, 1);
+
+    now();
+
+    qCDebug(lcWatchdog) << "Watching the event loop with a stall threshold of" << mThreshold << "ms"
+                        << "and a systemd watchdog interval of" << mSystemdInterval << "us";
+
+    sEnabled.store(1);
+    start(QThread::HighPriority);
+}
+
+void Watchdog::stop()
+{
+    sEnabled.store(0);
+    mStopping.store(1);
+    wait();
+}
+
+void Watchdog::onPing(int sequence)
+{
+    mAnswered.store(sequence);
+}
+
+void Watchdog::run()
+{
+    int sequence = 0;
+    qint64 lastFed = 0;
+
+    // Feed systemd twice per interval as recommended
+    qint64 feedInterval = mSystemdInterval / 2000;
+
+    while (!mStopping.load()) {
+        sequence++;
+        qint64 sent = now();
+        QMetaObject::invokeMethod(this, "onPing", Qt::QueuedConnection, Q_ARG(int, sequence));
+
+        bool stalled = false;
+        Stall stall;
+
+        while (!mStopping.load() && mAnswered.load() != sequence) {
+            msleep(CHECK_INTERVAL);
+
+            if (!stalled && mThreshold > 0 && now() - sent > mThreshold) {
+                stalled = true;
+                stall.time = sent;
+                captureStall(stall);
+            }
+        }
+
+        if (stalled) {
+            stall.duration = now() - sent;
+            recordStall(stall);
+        }
+
+        // Only an event loop which answered keeps systemd quiet
+        if (feedInterval > 0 && now() - lastFed >= feedInterval) {
+            sd_notify(0, "WATCHDOG=1");
+            lastFed = now();
+        }
+
+        msleep(PING_INTERVAL);
+    }
+}
+
+QString Watchdog::currentSource() const
+{
+    QMutexLocker locker(&mSourceLock);
+
+    if (mSource.kind) {
+        QString source = QString("%1:%2").arg(mSource.kind)
+                .arg(mSource.label ? QString(mSource.label) : mSource.name);
+        if (!mSource.detail.isEmpty())
+            source += "." + mSource.detail;
+        return source;
+    }
+
+    const char *eventClass = sEventClass.load();
+    if (eventClass)
+        return QString("event:%1/%2").arg(eventClass).arg(sEventType.load());
+
+    return QString("unknown");
+}
+
+void Watchdog::captureStall(Stall &stall)
+{
+    stall.source = currentSource();
+
+    sBacktraceDepth = -1;
+    pthread_kill(mGuiThread, SIGUSR2);
+
+    qint64 requested = now();
+    while (sBacktraceDepth < 0 && now() - requested < BACKTRACE_TIMEOUT)
+        usleep(1000);
+
+    int depth = sBacktraceDepth;
+    if (depth <= 0)
+        return;
+
+    char **symbols = backtrace_symbols(sBacktrace, depth);
+    if (!symbols)
+        return;
+
+    // Skip the signal handler and the trampoline
+    for (int n = 2; n < depth; n++)
+        stall.backtrace.append(QString::fromLocal8Bit(symbols[n]));
+
+    free(symbols);
+}
+
+void Watchdog::recordStall(const Stall &stall)
+{
+    qWarning() << "Event loop stalled for" << stall.duration << "ms in" << stall.source;
+    qCDebug(lcWatchdog) << "Backtrace of the stall:" << stall.backtrace;
+
+    QMutexLocker locker(&mStatisticsLock);
+
+    mStallCount++;
+
+    SourceStatistics &source = mSources[stall.source];
+    source.count++;
+    source.totalTime += stall.duration;
+    source.longest = qMax(source.longest, stall.duration);
+
+    mRecentStalls.append(stall);
+    if (mRecentStalls.size() > MAX_RECENT_STALLS)
+        mRecentStalls.removeFirst();
+}
+
+QJsonObject Watchdog::statistics() const
+{
+    QMutexLocker locker(&mStatisticsLock);
+
+    QJsonArray sources;
+    QMap<QString, SourceStatistics>::const_iterator iter;
+    for (iter = mSources.constBegin(); iter != mSources.constEnd(); ++iter) {
+        QJsonObject source;
+        source.insert("source", iter.key());
+        source.insert("count", iter.value().count);
+        source.insert("totalTime", iter.value().totalTime);
+        source.insert("longest", iter.value().longest);
+        sources.append(source);
+    }
+
+    QJsonArray recent;
+    Q_FOREACH(const Stall &stall, mRecentStalls) {
+        QJsonObject stallObj;
+        stallObj.insert("time", stall.time);
+        stallObj.insert("duration", stall.duration);
+        stallObj.insert("source", stall.source);
+        stallObj.insert("backtrace", QJsonArray::fromStringList(stall.backtrace));
+        recent.append(stallObj);
+    }
+
+    QJsonObject result;
+    result.insert("threshold", mThreshold);
+    result.insert("stalls", mStallCount);
+    result.insert("sources", sources);
+    result.insert("recent", recent);
+
+    return result;
+}
+
+} // namespace luna
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include <pthread.h>
+
+class QEvent;
+
+namespace luna
+{
+
+/*
+ * Pings the event loop of the GUI thread from its own thread. When a ping
+ * stays unanswered longer than the threshold the GUI thread is considered
+ * stalled: the handler or event being processed and a backtrace of the GUI
+ * thread are recorded and the stalls are counted per source.
+ *
+ * When systemd supervises us the watchdog is only fed while the event loop
+ * answers, so a hard hang gets us restarted.
+ */
+class Watchdog : public QThread
+{
+    Q_OBJECT
+
+    // What the GUI thread is busy with; only put into words once a stall
+    // is captured
+    struct Source
+    {
+        Source() : kind(0), label(0) { }
+
+        const char *kind;
+        const char *label;
+        QString name;
+        QString detail;
+    };
+
+public:
+    // Names what the GUI thread is busy with for the lifetime of the scope,
+    // does nothing while the watchdog isn't running
+    class Scope
+    {
+    public:
+        Scope(const char *kind, const char *label);
+        Scope(const char *kind, const QString &name, const QString &detail = QString());
+        ~Scope();
+
+    private:
+        bool mActive;
+        Source mPrevious;
+
+        void enter(const Source &source);
+    };
+
+    // Remembers the event being delivered for the lifetime of the scope
+    class EventScope
+    {
+    public:
+        EventScope(QObject *receiver, QEvent *event);
+        ~EventScope();
+
+    private:
+        const char *mPreviousClass;
+        int mPreviousType;
+    };
+
+    static Watchdog* instance();
+
+    void enable(int threshold, quint64 systemdInterval);
+    void stop();
+
+    QJsonObject statistics() const;
+
+protected:
+    void run();
+
+private Q_SLOTS:
+    void onPing(int sequence);
+
+private:
+    Watchdog();
+
+    struct Stall
+    {
+        qint64 time;
+        qint64 duration;
+        QString source;
+        QStringList backtrace;
+    };
+
+    struct SourceStatistics
+    {
+        int count;
+        qint64 totalTime;
+        qint64 longest;
+    };
+
+    void captureStall(Stall &stall);
+    void recordStall(const Stall &stall);
+    QString currentSource() const;
+
+    int mThreshold;
+    quint64 mSystemdInterval;
+    pthread_t mGuiThread;
+    QAtomicInt mStopping;
+    QAtomicInt mAnswered;
+
+    mutable QMutex mSourceLock;
+    Source mSource;
+
+    mutable QMutex mStatisticsLock;
+    QList<Stall> mRecentStalls;
+    QMap<QString, SourceStatistics> mSources;
+    int mStallCount;
+};
+
+} // namespace luna
+
+#endif // WATCHDOG_H
@@ -19,6 +19,7 @@
 #include <QQmlContext>
 #include <QJsonObject>
 #include <QJsonDocument>
+#include <QDateTime>
 
 #include <QtWebKit/private/qquickwebview_p.h>
 #ifndef WITH_UNMODIFIED_QTWEBKI
@@ -32,6 +33,10 @@
 #include "applicationdescription.h"
 #include "webapplication.h"
 #include "webapplicationwindow.h"
+#include "resourcepathvalidator.h"
+#include "logging.h"
+#include "framestatistics.h"
+#include "watchdog.h"
 
 #include <Settings.h>
 
@@ -41,75 +46,6 @@
 namespace luna
 {
 
-class ResourcePathValidator
-{
-public:
-    static ResourcePathValidator& instance()
-    {
-        static ResourcePathValidator instance;
-        return instance;
-    }
-
-    bool validate(const QString &path, bool privileged)
-    {
-        if (findPathInList(mAllowedTargetPaths, path))
-            return true;
-        if (privileged && findPathInList(mPrivilegedAppPaths, path))
-            return true;
-        if (!privileged && findPathInList(mUnprivilegedAppPaths, path))
-            return true;
-
-        return false;
-    }
-
-private:
-    ResourcePathValidator()
-    {
-        // NOTE: below set of paths are taken from the configuration set in the webkit used in
-        // webOS 3.0.5. See http://downloads.help.palm.com/opensource/3.0.5/webcore-patch.gz
-
-        // paths allowed for every app
-        mAllowedTargetPaths << "/usr/palm/frameworks";
-        mAllowedTargetPaths << "/media/internal";
-        mAllowedTargetPaths << "/usr/lib/luna/luna-media";
-        mAllowedTargetPaths << "/var/luna/files";
-        mAllowedTargetPaths << "/var/luna/data/extractfs";
-        mAllowedTargetPaths << "/var/luna/data/im-avatars";
-        mAllowedTargetPaths <<  "/usr/palm/applications/com.palm.app.contacts/sharedWidgets/";
-        mAllowedTargetPaths << "/usr/palm/sysmgr/";
-        mAllowedTargetPaths << "/usr/palm/public";
-        mAllowedTargetPaths << "/var/file-cache/";
-        mAllowedTargetPaths << "/usr/lib/luna/system/luna-systemui/images/";
-        mAllowedTargetPaths << "/usr/lib/luna/system/luna-systemui/app/FilePicker";
-
-        // paths only allowed for privileged apps
-        mPrivilegedAppPaths << "/usr/lib/luna/system/";   // system ui apps
-        mPrivilegedAppPaths << "/usr/palm/applications/";  // Palm apps
-        mPrivilegedAppPaths << "/var/usr/palm/applications/com.palm.";  // privileged apps like facebook
-        mPrivilegedAppPaths << "/media/cryptofs/apps/usr/palm/applications/com.palm.";  // privileged 3rd party apps
-        mPrivilegedAppPaths << "/usr/palm/sysmgr/";
-        mPrivilegedAppPaths << "/var/usr/palm/applications/com/palm/";
-        mPrivilegedAppPaths << "/media/cryptofs/apps/usr/palm/applications/com/palm/";
-
-        // additional paths allowed for unprivileged apps
-        mUnprivilegedAppPaths << "/var/usr/palm/applications/";
-        mUnprivilegedAppPaths << "/media/cryptofs/apps/usr/palm/applications/";
-    }
-
-    bool findPathInList(const QStringList &list, const QString &path)
-    {
-        Q_FOREACH(QString item, list) {
-            if (path.startsWith(item))
-                return true;
-        }
-        return false;
-    }
-
-    QStringList mAllowedTargetPaths;
-    QStringList mPrivilegedAppPaths;
-    QStringList mUnprivilegedAppPaths;
-};
-
 WebApplication::WebApplication(WebAppManager *launcher, const QUrl& url, const QString& windowType,
                                const ApplicationDescription& desc, const QString& parameters,
                                const int64_t processId, QObject *parent) :
@@ -117,14 +53,20 @@ WebApplication::WebApplication(WebAppManager *launcher, const QUrl& url, const Q
     mLauncher(launcher),
     mDescription(desc),
     mProcessId(processId),
+    mEntryPoint(url),
+    mWindowType(windowType),
+    mLaunchStage(LaunchStageIdle),
+    mPageLoaded(false),
     mIdentifier(QString("%1 %2").arg(mDescription.id()).arg(mProcessId)),
     mParameters(parameters),
     mMainWindow(0),
     mLaunchedAtBoot(false),
     mPrivileged(false),
+    mLastActive(QDateTime::currentMSecsSinceEpoch()),
+    mLaunchHidden(desc.launchHidden() && !desc.headless()),
     mActivity(mIdentifier, desc.id(), processId)
 {
-    qDebug() << __PRETTY_FUNCTION__ << this;
+    qCDebug(lcLaunch) << __PRETTY_FUNCTION__ << this;
 
     // Only system applications with a specific id prefix are privileged to access
     // the private luna bus
@@ -132,16 +74,12 @@ WebApplication::WebApplication(WebAppManager *launcher, const QUrl& url, const Q
         mDescription.id().startsWith("org.webosinternals"))
         mPrivileged = true;
 
-    mMainWindow = new WebApplicationWindow(this, url, windowType,
-            QSize(Settings::LunaSettings()->displayWidth, Settings::LunaSettings()->displayHeight),
-            mDescription.headless());
-
     processParameters();
 }
 
 WebApplication::~WebApplication()
 {
-    qDebug() << __PRETTY_FUNCTION__ << this;
+    qCDebug(lcLaunch) << __PRETTY_FUNCTION__ << this;
 
     Q_FOREACH(WebApplicationWindow *window, mChildWindows) {
         mChildWindows.removeAll(window);
@@ -152,6 +90,97 @@ WebApplication::~WebApplication()
         delete mMainWindow;
 }
 
+void WebApplication::launch()
+{
+    if (mLaunchStage != LaunchStageIdle)
+        return;
+
+    mLaunchStage = LaunchStageActivity;
+    QMetaObject::invokeMethod(this, "onContinueLaunch", Qt::QueuedConnection);
+}
+
+bool WebApplication::launching() const
+{
+    return mLaunchStage != LaunchStageIdle && mLaunchStage != LaunchStageDone;
+}
+
+void WebApplication::onContinueLaunch()
+{
+    qCDebug(lcLaunch) << __PRETTY_FUNCTION__ << "id" << id() << "stage" << mLaunchStage;
+
+    FrameStatistics::WorkScope work(FrameStatistics::WorkLaunch);
+    Watchdog::Scope watchdog("launch", id());
+
+    // Every stage runs in its own event loop iteration so service calls and
+    // other applications can make progress in between
+    switch (mLaunchStage) {
+    case LaunchStageActivity:
+        mActivity.setup();
+        break;
+    case LaunchStageWindow:
+        mMainWindow = new WebApplicationWindow(this, mEntryPoint, mWindowType,
+                QSize(Settings::LunaSettings()->displayWidth, Settings::LunaSettings()->displayHeight),
+                mDescription.headless());
+        connect(mMainWindow, SIGNAL(loadSucceeded()), this, SLOT(onLoaded()));
+        connect(mMainWindow, SIGNAL(loadFailed()), this, SLOT(onLoadFailed()));
+        if (!mDescription.renderProfile().isEmpty())
+            mMainWindow->setRenderProfile(mDescription.renderProfile());
+        if (mLaunchHidden)
+            mMainWindow->setLaunchedHidden(true, mDescription.hiddenLaunchMode() == "defer");
+        break;
+    case LaunchStagePlatformWindow:
+        mMainWindow->createPlatformWindow();
+        break;
+    case LaunchStageContainer:
+        if (!mMainWindow->loadContainer()) {
+            mLaunchStage = LaunchStageDone;
+            emit launchFailed();
+            return;
+        }
+        break;
+    default:
+        return;
+    }
+
+    mLaunchStage = static_cast<LaunchStage>(mLaunchStage + 1);
+
+    if (mLaunchStage == LaunchStageDone) {
+        emit launched();
+        return;
+    }
+
+    QMetaObject::invokeMethod(this, "onContinueLaunch", Qt::QueuedConnection);
+}
+
+void WebApplication::onLoaded()
+{
+    if (!mPageLoaded) {
+        mPageLoaded = true;
+
+        // Launch requests which came in while we were still loading are
+        // delivered in the order they arrived now that the page can handle them
+        QStringList pendingRelaunches = mPendingRelaunches;
+        mPendingRelaunches.clear();
+
+        Q_FOREACH(const QString &parameters, pendingRelaunches)
+            relaunch(parameters);
+    }
+
+    emit loaded();
+}
+
+void WebApplication::onLoadFailed()
+{
+    // Nobody is going to handle the launches we kept for the page anymore
+    if (!mPageLoaded && !mPendingRelaunches.isEmpty()) {
+        qCWarning(lcLaunch) << "Dropping" << mPendingRelaunches.size() << "pending relaunches of"
+                            << mDescription.id() << "as its page failed to load";
+        mPendingRelaunches.clear();
+    }
+
+    emit loadFailed();
+}
+
 void WebApplication::processParameters()
 {
     QJsonDocument document = QJsonDocument::fromJson(mParameters.toUtf8());
@@ -165,6 +194,8 @@ void WebApplication::processParameters()
 
 void WebApplication::changeActivityFocus(bool focus)
 {
+    mLastActive = QDateTime::currentMSecsSinceEpoch();
+
     if (focus)
         mActivity.focus();
     else
@@ -173,7 +204,23 @@ void WebApplication::changeActivityFocus(bool focus)
 
 void WebApplication::relaunch(const QString &parameters)
 {
-    qDebug() << __PRETTY_FUNCTION__ << "Relaunching application" << mDescription.id() << "with parameters" << parameters;
+    qCDebug(lcLaunch) << __PRETTY_FUNCTION__ << "Relaunching application" << mDescription.id() << "with parameters" << parameters;
+
+    // A deferred web view doesn't exist before the window is shown and then
+    // starts with whatever parameters we have at that point
+    if (mMainWindow && mMainWindow->deferWebView() && !mMainWindow->webView()) {
+        mParameters = parameters;
+        emit parametersChanged();
+        return;
+    }
+
+    // The page isn't able to handle a relaunch yet and would lose the
+    // parameters of the initial launch, so keep it for later
+    if (!mPageLoaded) {
+        qCDebug(lcLaunch) << "Deferring relaunch of" << mDescription.id() << "until the page is loaded";
+        mPendingRelaunches.append(parameters);
+        return;
+    }
 
     mParameters = parameters;
     emit parametersChanged();
@@ -188,11 +235,11 @@ void WebApplication::createWindow(QWebNewPageRequest *request)
     int width = Settings::LunaSettings()->displayWidth;
     int height = Settings::LunaSettings()->displayHeight;
 
-    qDebug() << __PRETTY_FUNCTION__ << "Creating new window for url" << request->url();
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "Creating new window for url" << request->url();
 
     QVariantMap windowFeatures = request->windowFeatures();
     foreach(QString key, windowFeatures.keys()) {
-        qDebug() << "[" << key << "] = " << windowFeatures.value(key);
+        qCDebug(lcWindow) << "[" << key << "] = " << windowFeatures.value(key);
     }
 
     // child windows can never be headless ones!
@@ -224,10 +271,13 @@ void WebApplication::createWindow(QWebNewPageRequest *request)
         }
     }
 
-    qDebug() << Q_FUNC_INFO << "Setting parent window id" << mMainWindow->windowId() << "for new window";
+    int parentWindowId = mMainWindow ? mMainWindow->windowId() : 0;
+
+    qCDebug(lcWindow) << Q_FUNC_INFO << "Setting parent window id" << parentWindowId << "for new window";
     WebApplicationWindow *window = new WebApplicationWindow(this, request->url(),
                                                             windowType, QSize(width, height), false,
-                                                            mMainWindow->windowId());
+                                                            parentWindowId);
+    window->createAndSetup();
 
     request->setWebView(window->webView());
 
@@ -240,7 +290,7 @@ void WebApplication::closeWindow(WebApplicationWindow *window)
 {
     // if the window is marked as keep alive we don't close it
     if (window->keepAlive()) {
-        qDebug() << "Not closing window cause it was configured to be kept alive";
+        qCDebug(lcWindow) << "Not closing window cause it was configured to be kept alive";
         return;
     }
 
@@ -253,29 +303,27 @@ void WebApplication::closeWindow(WebApplicationWindow *window)
 
         // if no child window is left close the main (headless) window too
         if (mChildWindows.count() == 0 && !mLaunchedAtBoot && headless()) {
-            qDebug() << "All child windows of app" << id()
+            qCDebug(lcWindow) << "All child windows of app" << id()
                      << "were closed so closing the main window too";
 
+            // The window stays with us until the teardown takes it apart
             mMainWindow->destroy();
-            mMainWindow->deleteLater();
-            mMainWindow = 0;
+            mPendingRelaunches.clear();
 
             emit closed();
         }
     }
     else if (window == mMainWindow) {
-        // the main window was closed so close all child windows too
+        // the main window was closed so close all child windows too; all of
+        // them stay with us until the teardown takes them apart
         mMainWindow->destroy();
-        mMainWindow->deleteLater();
-        mMainWindow = 0;
+        mPendingRelaunches.clear();
 
-        qDebug() << "The main window of app " << id()
+        qCDebug(lcWindow) << "The main window of app " << id()
                  << "was closed, so closing all child windows too";
 
-        foreach(WebApplicationWindow *childWindow, mChildWindows) {
+        foreach(WebApplicationWindow *childWindow, mChildWindows)
             childWindow->destroy();
-            childWindow->deleteLater();
-        }
 
         emit closed();
     }
@@ -283,12 +331,35 @@ void WebApplication::closeWindow(WebApplicationWindow *window)
 
 void WebApplication::kill()
 {
+    mPendingRelaunches.clear();
+
     emit closed();
 }
 
+void WebApplication::hide()
+{
+    Q_FOREACH(WebApplicationWindow *window, windows())
+        window->hide();
+}
+
+QList<WebApplicationWindow*> WebApplication::takeWindows()
+{
+    // A launch still in progress must not create anything new anymore
+    if (launching())
+        mLaunchStage = LaunchStageDone;
+
+    QList<WebApplicationWindow*> taken = windows();
+
+    mMainWindow = 0;
+    mChildWindows.clear();
+
+    return taken;
+}
+
 void WebApplication::clearMemoryCaches()
 {
-    mMainWindow->clearMemoryCaches();
+    if (mMainWindow)
+        mMainWindow->clearMemoryCaches();
 
     foreach (WebApplicationWindow *window, mChildWindows)
         window->clearMemoryCaches();
@@ -382,6 +453,51 @@ ApplicationDescription WebApplication::desc() const
     return mDescription;
 }
 
+WebApplicationWindow* WebApplication::mainWindow() const
+{
+    return mMainWindow;
+}
+
+QList<WebApplicationWindow*> WebApplication::windows() const
+{
+    QList<WebApplicationWindow*> windows;
+
+    if (mMainWindow)
+        windows.append(mMainWindow);
+
+    windows.append(mChildWindows);
+
+    return windows;
+}
+
+bool WebApplication::visible() const
+{
+    return mMainWindow && mMainWindow->visible();
+}
+
+qint64 WebApplication::lastActive() const
+{
+    return mLastActive;
+}
+
+bool WebApplication::launchHidden() const
+{
+    return mLaunchHidden;
+}
+
+void WebApplication::unhide()
+{
+    if (!mLaunchHidden)
+        return;
+
+    qCDebug(lcLaunch) << "Application" << id() << "launched hidden is requested to be shown";
+
+    mLaunchHidden = false;
+
+    if (mMainWindow)
+        mMainWindow->setLaunchedHidden(false);
+}
+
 bool WebApplication::isLauncher() const
 {
     return mDescription.id() == "com.palm.launcher";
@@ -58,6 +58,9 @@ public:
                    const int64_t processId, QObject *parent = 0);
     virtual ~WebApplication();
 
+    void launch();
+    bool launching() const;
+
     QString id() const;
     int64_t processId() const;
     QUrl url() const;
@@ -74,6 +77,16 @@ public:
     bool loadingAnimationDisabled() const;
     bool allowCrossDomainAccess() const;
     ApplicationDescription desc() const;
+    WebApplicationWindow* mainWindow() const;
+    QList<WebApplicationWindow*> windows() const;
+    bool visible() const;
+    qint64 lastActive() const;
+    bool launchHidden() const;
+
+    void unhide();
+
+    void hide();
+    QList<WebApplicationWindow*> takeWindows();
 
     void changeActivityFocus(bool focus);
 
@@ -97,20 +110,45 @@ public Q_SLOTS:
 Q_SIGNALS:
     void closed();
     void parametersChanged();
+    void launched();
+    void launchFailed();
+    void loaded();
+    void loadFailed();
+
+private Q_SLOTS:
+    void onContinueLaunch();
+    void onLoaded();
+    void onLoadFailed();
 
 private:
+    enum LaunchStage {
+        LaunchStageIdle = 0,
+        LaunchStageActivity,
+        LaunchStageWindow,
+        LaunchStagePlatformWindow,
+        LaunchStageContainer,
+        LaunchStageDone
+    };
+
     void processParameters();
 
 private:
     WebAppManager *mLauncher;
     ApplicationDescription mDescription;
     int64_t mProcessId;
+    QUrl mEntryPoint;
+    QString mWindowType;
+    LaunchStage mLaunchStage;
+    bool mPageLoaded;
+    QStringList mPendingRelaunches;
     QString mIdentifier;
     QString mParameters;
     WebApplicationWindow *mMainWindow;
     QList<WebApplicationWindow*> mChildWindows;
     bool mLaunchedAtBoot;
     bool mPrivileged;
+    qint64 mLastActive;
+    bool mLaunchHidden;
     Activity mActivity;
 };
 
@@ -18,12 +18,14 @@
 #include <QDebug>
 
 #include "webapplicationplugin.h"
+#include "logging.h"
 
 namespace luna
 {
 
 WebApplicationPlugin::WebApplicationPlugin(const QFileInfo &path, QObject *parent) :
     QObject(parent),
+    mInstance(0),
     mPath(path)
 {
 }
@@ -45,8 +47,27 @@ bool WebApplicationPlugin::load()
     return true;
 }
 
+void WebApplicationPlugin::unload()
+{
+    if (!mLoader.isLoaded())
+        return;
+
+    mInstance = 0;
+
+    if (!mLoader.unload())
+        qWarning() << "Failed to unload application plugin: " << mLoader.errorString();
+}
+
+bool WebApplicationPlugin::isLoaded() const
+{
+    return mInstance != 0;
+}
+
 QList<BaseExtension*> WebApplicationPlugin::createExtensions(ApplicationEnvironment *environment)
 {
+    if (Q_UNLIKELY(mInstance == 0))
+        return QList<BaseExtension*>();
+
     return mInstance->createExtensions(environment);
 }
 
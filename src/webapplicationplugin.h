@@ -37,6 +37,8 @@ public:
     WebApplicationPlugin(const QFileInfo &path, QObject *parent = 0);
 
     bool load();
+    void unload();
+    bool isLoaded() const;
 
     QList<BaseExtension*> createExtensions(ApplicationEnvironment *environment);
 
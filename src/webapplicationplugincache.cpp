@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDebug>
+#include <QDir>
+
+#include "webapplicationplugin.h"
+#include "webapplicationplugincache.h"
+#include "logging.h"
+
+// Time a plugin stays loaded after the last window using it went away so a
+// quick relaunch of the application doesn't have to load it again
+#define PLUGIN_UNLOAD_GRACE_PERIOD  30000
+
+namespace luna
+{
+
+WebApplicationPluginCache* WebApplicationPluginCache::instance()
+{
+    static WebApplicationPluginCache* instance = 0;
+
+    if (!instance)
+        instance = new WebApplicationPluginCache();
+
+    return instance;
+}
+
+WebApplicationPluginCache::WebApplicationPluginCache() :
+    mUnloadTimer(this)
+{
+    mUnloadTimer.setSingleShot(true);
+    mUnloadTimer.setInterval(PLUGIN_UNLOAD_GRACE_PERIOD);
+    connect(&mUnloadTimer, SIGNAL(timeout()), this, SLOT(onUnloadTimeout()));
+}
+
+void WebApplicationPluginCache::buildIndex(const QString &directory)
+{
+    QDir pluginDir(directory);
+
+    if (!pluginDir.exists()) {
+        qCDebug(lcExtensions) << "Application plugin directory" << directory << "doesn't exist";
+        return;
+    }
+
+    QFileInfoList entries = pluginDir.entryInfoList(QStringList() << "*.so", QDir::Files | QDir::Readable);
+
+    Q_FOREACH(QFileInfo entry, entries) {
+        // Plugins are referenced without the usual library prefix so
+        // libfoo.so can be found as foo as well as libfoo
+        QString name = entry.baseName();
+        if (name.startsWith("lib") && name.length() > 3)
+            mIndex.insert(name.mid(3), entry);
+
+        mIndex.insert(name, entry);
+    }
+
+    qCDebug(lcExtensions) << "Found" << entries.count() << "application plugins in" << directory;
+}
+
+WebApplicationPlugin* WebApplicationPluginCache::acquire(const QString &name)
+{
+    if (mPlugins.contains(name)) {
+        Entry &entry = mPlugins[name];
+        entry.references++;
+        return entry.plugin;
+    }
+
+    if (mFailedPlugins.contains(name))
+        return 0;
+
+    if (!mIndex.contains(name)) {
+        qWarning() << "Could not find application plugin" << name;
+        mFailedPlugins.insert(name);
+        return 0;
+    }
+
+    WebApplicationPlugin *plugin = new WebApplicationPlugin(mIndex.value(name), this);
+    if (!plugin->load()) {
+        delete plugin;
+        mFailedPlugins.insert(name);
+        return 0;
+    }
+
+    qCDebug(lcExtensions) << "Loaded application plugin" << name << "from" << mIndex.value(name).filePath();
+
+    Entry entry;
+    entry.plugin = plugin;
+    entry.references = 1;
+    mPlugins.insert(name, entry);
+
+    return plugin;
+}
+
+void WebApplicationPluginCache::release(WebApplicationPlugin *plugin)
+{
+    QMap<QString, Entry>::iterator iter;
+    for (iter = mPlugins.begin(); iter != mPlugins.end(); ++iter) {
+        if (iter.value().plugin != plugin)
+            continue;
+
+        if (--iter.value().references == 0)
+            mUnloadTimer.start();
+
+        return;
+    }
+
+    qWarning() << "BUG: Releasing an application plugin which isn't cached";
+}
+
+void WebApplicationPluginCache::onUnloadTimeout()
+{
+    QMap<QString, Entry>::iterator iter = mPlugins.begin();
+    while (iter != mPlugins.end()) {
+        if (iter.value().references > 0) {
+            ++iter;
+            continue;
+        }
+
+        qCDebug(lcExtensions) << "Unloading unused application plugin" << iter.key();
+
+        WebApplicationPlugin *plugin = iter.value().plugin;
+        plugin->unload();
+        delete plugin;
+
+        iter = mPlugins.erase(iter);
+    }
+}
+
+} // namespace luna
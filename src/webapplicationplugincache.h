@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WEBAPPLICATIONPLUGINCACHE_H
+#define WEBAPPLICATIONPLUGINCACHE_H
+
+#include <QObject>
+#include <QMap>
+#include <QSet>
+#include <QFileInfo>
+#include <QTimer>
+
+namespace luna
+{
+
+class WebApplicationPlugin;
+
+/*
+ * Process wide cache of native application plugins. Plugins are looked up by
+ * the name an application specifies in its description, loaded once and
+ * shared between all windows (and relaunches) of the application. A plugin
+ * is unloaded again after a short grace period once no window references it
+ * anymore.
+ */
+class WebApplicationPluginCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static WebApplicationPluginCache* instance();
+
+    void buildIndex(const QString &directory);
+
+    WebApplicationPlugin* acquire(const QString &name);
+    void release(WebApplicationPlugin *plugin);
+
+private Q_SLOTS:
+    void onUnloadTimeout();
+
+private:
+    WebApplicationPluginCache();
+
+    struct Entry
+    {
+        WebApplicationPlugin *plugin;
+        int references;
+    };
+
+    QMap<QString, QFileInfo> mIndex;
+    QMap<QString, Entry> mPlugins;
+    QSet<QString> mFailedPlugins;
+    QTimer mUnloadTimer;
+};
+
+} // namespace luna
+
+#endif // WEBAPPLICATIONPLUGINCACHE_H
@@ -23,26 +23,65 @@
 #include <QtWebKit/private/qwebnewpagerequest_p.h>
 #endif
 #include <QtGui/QGuiApplication>
-#include <QtGui/qpa/qplatformnativeinterface.h>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QTimer>
+#include <QDir>
+#include <QFile>
+#include <QImage>
 
 #include <QScreen>
 
+#include <unistd.h>
+
 #include <Settings.h>
 
 #include "applicationdescription.h"
+#include "applicationhistory.h"
 #include "webapplication.h"
 #include "webapplicationwindow.h"
+#include "webapplicationplugin.h"
+#include "webapplicationplugincache.h"
+#include "windowpool.h"
+#include "windowpropertydispatcher.h"
+#include "framestatistics.h"
+#include "watchdog.h"
+#include "logging.h"
+#include "utils.h"
 
 #include "extensions/palmsystemextension.h"
 #include "extensions/wifimanager.h"
 #include "extensions/inappbrowserextension.h"
 
+#define RESOURCE_RELEASE_MEASURE_DELAY  1000
+
 namespace luna
 {
 
+// Upper and lower bound for how long we wait for an application which
+// called stagePreparing to call stageReady before its window is shown
+#define STAGE_READY_TIMEOUT_MAX     3000
+#define STAGE_READY_TIMEOUT_MIN     500
+
+// How long a ready window waits for its content to be painted before it's
+// shown anyway
+#define FIRST_PAINT_TIMEOUT         1000
+
+// How long a window has to be hidden before it gives up its rendering
+// resources, a negative value disables releasing them
+static int sResourceReleaseDelay = -1;
+
+// Whether windows still preparing their stage are shown as soon as their
+// content is painted
+static bool sShowOnFirstPaint = false;
+
+// Without a compositor (e.g. on a build machine) windows are rendered with the
+// offscreen platform which neither provides GLES nor window properties
+static bool isOffscreenPlatform()
+{
+    return QGuiApplication::platformName() == "offscreen";
+}
+
 WebApplicationWindow::WebApplicationWindow(WebApplication *application, const QUrl& url,
                                            const QString& windowType, const QSize& size,
                                            bool headless,
@@ -50,52 +89,119 @@ WebApplicationWindow::WebApplicationWindow(WebApplication *application, const QU
                                            QObject *parent) :
     ApplicationEnvironment(parent),
     mApplication(application),
+    mPlugin(0),
     mEngine(0),
+    mContext(0),
     mRootItem(0),
     mWindow(0),
     mHeadless(headless),
+    mWebView(0),
     mUrl(url),
     mWindowType(windowType),
     mKeepAlive(false),
     mStagePreparing(true),
     mStageReady(false),
     mStageReadyTimer(this),
+    mStageReadyOverdue(false),
+    mFirstPaint(false),
+    mFirstPaintTimer(this),
     mSize(size),
     mWindowId(0),
     mParentWindowId(parentWindowId),
     mLoadingAnimationDisabled(false),
-    mLaunchedHidden(application->id() == "com.palm.launcher")
+    mLaunchedHidden(false),
+    mDeferWebView(false),
+    mRenderProfile(new RenderProfile(headless ? QString("headless") : windowType, this)),
+    mFrameStatistics(0),
+    mReleaseTimer(this),
+    mResourcesReleased(false)
 {
-    qDebug() << __PRETTY_FUNCTION__ << this << size;
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << this << size;
 
     connect(&mStageReadyTimer, SIGNAL(timeout()), this, SLOT(onStageReadyTimeout()));
     mStageReadyTimer.setSingleShot(true);
 
+    connect(&mFirstPaintTimer, SIGNAL(timeout()), this, SLOT(onFirstPaintTimeout()));
+    mFirstPaintTimer.setSingleShot(true);
+    mFirstPaintTimer.setInterval(FIRST_PAINT_TIMEOUT);
+
+    connect(&mReleaseTimer, SIGNAL(timeout()), this, SLOT(onReleaseResources()));
+    mReleaseTimer.setSingleShot(true);
+
     assignCorrectTrustScope();
 
-    createAndSetup();
+    if (mTrustScope == TrustScopeSystem) {
+        mUserScripts.append(QUrl("qrc:///qml/webos-api.js"));
+        createDefaultExtensions();
+    }
+
+    if (mWindowType == "dashboard")
+        mLoadingAnimationDisabled = true;
 }
 
 WebApplicationWindow::~WebApplicationWindow()
 {
-    qDebug() << __PRETTY_FUNCTION__ << this;
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << this;
 
     Q_FOREACH(BaseExtension *extension, mExtensions.values())
         delete extension;
 
     mExtensions.clear();
 
-    if (mHeadless)
+    // All extensions created by the plugin are gone now so it's safe to
+    // give up our reference
+    if (mPlugin)
+        WebApplicationPluginCache::instance()->release(mPlugin);
+
+    if (mHeadless) {
+        delete mContext;
         delete mEngine;
+    }
+
+    // Everything tying the view to us goes, the view itself may be reused
+    // for the next window of the same type
+    if (mWindow) {
+        delete mFrameStatistics;
+        mWindow->removeEventFilter(this);
+        disconnect(mWindow, 0, this, 0);
+        WindowPropertyDispatcher::instance()->remove(mWindow->handle());
+        WindowPool::instance()->release(mWindowType, mWindow);
+
+        // Only now the container is gone which was created in it
+        delete mContext;
+    }
+
+    if (!mSnapshotPath.isEmpty())
+        QFile::remove(mSnapshotPath);
+}
+
+void WebApplicationWindow::releaseWebView()
+{
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+
+    mStageReadyTimer.stop();
+    mFirstPaintTimer.stop();
+    mReleaseTimer.stop();
 
+    // Dropping the container takes the web view and with it the web process
+    // down; everything else stays until we're deleted
     if (mWindow)
-        delete mWindow;
+        mWindow->setSource(QUrl());
+    else if (mRootItem) {
+        delete mRootItem;
+        mRootItem = 0;
+    }
+
+    mWebView = 0;
 }
 
 void WebApplicationWindow::destroy()
 {
-    if (mWindow)
-        mWindow->destroy();
+    if (!mWindow)
+        return;
+
+    WindowPropertyDispatcher::instance()->remove(mWindow->handle());
+    mWindow->destroy();
 }
 
 void WebApplicationWindow::assignCorrectTrustScope()
@@ -108,19 +214,19 @@ void WebApplicationWindow::assignCorrectTrustScope()
 
 void WebApplicationWindow::setWindowProperty(const QString &name, const QVariant &value)
 {
-    QPlatformNativeInterface *nativeInterface = QGuiApplication::platformNativeInterface();
-    nativeInterface->setWindowProperty(mWindow->handle(), name, value);
+    mProperties.setProperty(name, value);
 }
 
 QVariant WebApplicationWindow::getWindowProperty(const QString &name)
 {
-    QPlatformNativeInterface *nativeInterface = QGuiApplication::platformNativeInterface();
-    return nativeInterface->windowProperty(mWindow->handle(), name);
+    return mProperties.property(name);
 }
 
 void WebApplicationWindow::updateWindowProperty(const QString &name)
 {
-    qDebug() << Q_FUNC_INFO << "Window property" << name << "was updated";
+    qCDebug(lcWindow) << Q_FUNC_INFO << "Window property" << name << "was updated";
+
+    mProperties.invalidate(name);
 
     if (name == "_LUNE_WINDOW_ID")
         mWindowId = getWindowProperty("_LUNE_WINDOW_ID").toInt();
@@ -128,97 +234,118 @@ void WebApplicationWindow::updateWindowProperty(const QString &name)
         mParentWindowId = getWindowProperty("_LUNE_WINDOW_PARENT_ID").toInt();
 }
 
-void WebApplicationWindow::onWindowPropertyChanged(QPlatformWindow *window, const QString &name)
-{
-    if (!mWindow)
-        return;
-
-    if (window != mWindow->handle())
-        return;
-
-    updateWindowProperty(name);
-}
-
 void WebApplicationWindow::configureQmlEngine()
 {
     if (!mEngine)
         return;
 
-    mEngine->rootContext()->setContextProperty("webApp", mApplication);
-    mEngine->rootContext()->setContextProperty("webAppWindow", this);
+    // The engine of a window might have served other applications before
+    // and will serve others after us, so everything the container sees of
+    // us lives in a context of its own which goes away with us
+    mContext = new QQmlContext(mEngine->rootContext());
+    mContext->setContextProperty("webApp", mApplication);
+    mContext->setContextProperty("webAppWindow", this);
 }
 
-void WebApplicationWindow::createAndSetup()
+bool WebApplicationWindow::createAndSetup()
 {
-    if (mTrustScope == TrustScopeSystem) {
-        mUserScripts.append(QUrl("qrc:///qml/webos-api.js"));
-        createDefaultExtensions();
-    }
-
-    if (mWindowType == "dashboard")
-        mLoadingAnimationDisabled = true;
+    createPlatformWindow();
+    return loadContainer();
+}
 
+void WebApplicationWindow::createPlatformWindow()
+{
     if (mHeadless) {
-        qDebug() << __PRETTY_FUNCTION__ << "Creating application container for headless ...";
-
         mEngine = new QQmlEngine;
         configureQmlEngine();
-
-        QQmlComponent component(mEngine, QUrl(QString("qrc:///qml/ApplicationContainer.qml")));
-        mRootItem = qobject_cast<QQuickItem*>(component.create());
     }
     else {
         QQuickWebViewExperimental::setFlickableViewportEnabled(mApplication->desc().flickable());
 
-        mWindow = new QQuickView;
+        mWindow = WindowPool::instance()->acquire(mWindowType);
         mWindow->installEventFilter(this);
 
-
         mEngine = mWindow->engine();
         configureQmlEngine();
 
-        connect(mWindow, &QObject::destroyed,  [=](QObject *obj) {
-            qDebug() << "Window destroyed";
+        connect(mWindow, &QObject::destroyed, this, [=](QObject *obj) {
+            qCDebug(lcWindow) << "Window destroyed";
         });
 
-        mWindow->setColor(Qt::transparent);
+        // Opaque windows save the compositor from blending them
+        mWindow->setColor(mRenderProfile->alphaBuffer() ? Qt::transparent : Qt::black);
 
         mWindow->reportContentOrientationChange(QGuiApplication::primaryScreen()->primaryOrientation());
 
         mWindow->setSurfaceType(QSurface::OpenGLSurface);
         QSurfaceFormat surfaceFormat = mWindow->format();
-        surfaceFormat.setAlphaBufferSize(8);
-        surfaceFormat.setRenderableType(QSurfaceFormat::OpenGLES);
+        // Contexts can only share resources when created with the same config,
+        // so all windows keep the alpha buffer then
+        bool alphaBuffer = mRenderProfile->alphaBuffer() ||
+                           QCoreApplication::testAttribute(Qt::AA_ShareOpenGLContexts);
+        surfaceFormat.setAlphaBufferSize(alphaBuffer ? 8 : 0);
+        if (!isOffscreenPlatform())
+            surfaceFormat.setRenderableType(QSurfaceFormat::OpenGLES);
         mWindow->setFormat(surfaceFormat);
 
-        // make sure the platform window gets created to be able to set it's
-        // window properties
-        mWindow->create();
-
-        // set different information bits for our window
+        // set different information bits for our window; they're staged
+        // until the platform window exists and then go out together before
+        // anything is rendered
+        mProperties.setWindow(mWindow);
         setWindowProperty(QString("_LUNE_WINDOW_TYPE"), QVariant(mWindowType));
         setWindowProperty(QString("_LUNE_WINDOW_PARENT_ID"), QVariant(mParentWindowId));
         setWindowProperty(QString("_LUNE_WINDOW_LOADING_ANIMATION_DISABLED"), QVariant(mApplication->loadingAnimationDisabled()));
         setWindowProperty(QString("_LUNE_APP_ICON"), QVariant(mApplication->icon()));
         setWindowProperty(QString("_LUNE_APP_ID"), QVariant(mApplication->id()));
 
+        mWindow->create();
+        mProperties.flush();
+
         connect(mWindow, SIGNAL(visibleChanged(bool)), this, SLOT(onVisibleChanged(bool)));
+        connect(mWindow, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()));
+
+        mFrameStatistics = new FrameStatistics(mWindow, this);
 
-        QPlatformNativeInterface *nativeInterface = QGuiApplication::platformNativeInterface();
-        connect(nativeInterface, SIGNAL(windowPropertyChanged(QPlatformWindow*, const QString&)),
-                this, SLOT(onWindowPropertyChanged(QPlatformWindow*, const QString&)));
+        // Without an OpenGL implementation the scene graph would abort the
+        // whole process; offscreen we're fine with not rendering anything
+        if (isOffscreenPlatform())
+            connect(mWindow, SIGNAL(sceneGraphError(QQuickWindow::SceneGraphError, const QString&)),
+                    this, SLOT(onSceneGraphError(QQuickWindow::SceneGraphError, const QString&)));
 
-        mWindow->setSource(QUrl(QString("qrc:///qml/ApplicationContainer.qml")));
+        WindowPropertyDispatcher::instance()->add(mWindow->handle(), this);
+    }
+}
+
+bool WebApplicationWindow::loadContainer()
+{
+    if (mHeadless) {
+        qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "Creating application container for headless ...";
+
+        QQmlComponent component(mEngine, QUrl(QString("qrc:///qml/ApplicationContainer.qml")));
+        mRootItem = qobject_cast<QQuickItem*>(component.create(mContext));
+    }
+    else {
+        // The view takes over the component and the container
+        QQmlComponent *component = new QQmlComponent(mEngine, QUrl(QString("qrc:///qml/ApplicationContainer.qml")));
+        QObject *container = component->create(mContext);
+        mWindow->setContent(component->url(), component, container);
 
         mRootItem = mWindow->rootObject();
 
         mWindow->resize(mSize);
     }
+
+    if (!mRootItem) {
+        qWarning() << "Failed to load the application container for app" << mApplication->id();
+        return false;
+    }
+
+    return true;
 }
 
 void WebApplicationWindow::configureWebView(QQuickItem *webViewItem)
 {
-    qDebug() << __PRETTY_FUNCTION__ << "Configuring application webview ...";
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "Configuring application webview ...";
 
     // mWebView = mRootItem->findChild<QQuickWebView*>("webView");
     mWebView = static_cast<QQuickWebView*>(webViewItem);
@@ -230,6 +357,8 @@ void WebApplicationWindow::configureWebView(QQuickItem *webViewItem)
 
     connect(mWebView, SIGNAL(loadingChanged(QWebLoadRequest*)),
             this, SLOT(onLoadingChanged(QWebLoadRequest*)));
+    connect(mWebView->experimental(), SIGNAL(loadVisuallyCommitted()),
+            this, SLOT(onLoadVisuallyCommitted()));
 
 #ifndef WITH_UNMODIFIED_QTWEBKIT
     connect(mWebView->experimental(), SIGNAL(createNewPage(QWebNewPageRequest*)),
@@ -251,18 +380,236 @@ void WebApplicationWindow::configureWebView(QQuickItem *webViewItem)
 
 void WebApplicationWindow::onStageReadyTimeout()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+
+    ApplicationHistory::instance()->recordStageReadyMissed(mApplication->id());
 
     stageReady();
+
+    // The page still tells us when it's ready eventually, which is what the
+    // next launch should wait for
+    mStageReadyOverdue = true;
+
+    // The user waited long enough, show whatever we have
+    if (mFirstPaintTimer.isActive())
+        onFirstPaintTimeout();
+}
+
+void WebApplicationWindow::onFirstPaintTimeout()
+{
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+
+    mFirstPaintTimer.stop();
+
+    if (mWindow && !mLaunchedHidden && !mWindow->isVisible())
+        mWindow->show();
+}
+
+void WebApplicationWindow::onLoadVisuallyCommitted()
+{
+    if (mFirstPaint)
+        return;
+
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+
+    mFirstPaint = true;
+
+    if (!mWindow || mLaunchedHidden || mWindow->isVisible())
+        return;
+
+    if (mFirstPaintTimer.isActive()) {
+        mFirstPaintTimer.stop();
+        mWindow->show();
+        return;
+    }
+
+    // Applications which never told us about being ready before get shown
+    // with their first content instead of after the timeout again
+    if (mStagePreparing && !mStageReady &&
+        (sShowOnFirstPaint || ApplicationHistory::instance()->stageReadyMissed(mApplication->id()))) {
+        qCDebug(lcWindow) << "Showing window of" << mApplication->id() << "before its stage is ready";
+        mWindow->show();
+    }
+}
+
+void WebApplicationWindow::showWhenPainted()
+{
+    if (!mWindow || mLaunchedHidden || mWindow->isVisible())
+        return;
+
+    // Without content the user would only see a blank card
+    if (mFirstPaint) {
+        mWindow->show();
+        return;
+    }
+
+    if (!mFirstPaintTimer.isActive())
+        mFirstPaintTimer.start();
+}
+
+int WebApplicationWindow::stageReadyTimeout() const
+{
+    qint64 delay = ApplicationHistory::instance()->stageReadyDelay(mApplication->id());
+    if (delay < 0)
+        return STAGE_READY_TIMEOUT_MAX;
+
+    return qBound<qint64>(STAGE_READY_TIMEOUT_MIN, delay * 2, STAGE_READY_TIMEOUT_MAX);
 }
 
 void WebApplicationWindow::onVisibleChanged(bool visible)
 {
-    qDebug() << __PRETTY_FUNCTION__ << visible;
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << visible;
+
+    if (visible)
+        restoreResources();
+    else if (sResourceReleaseDelay >= 0 && !mResourcesReleased)
+        mReleaseTimer.start(sResourceReleaseDelay);
 
     emit visibleChanged();
 }
 
+void WebApplicationWindow::setLaunchedHidden(bool hidden, bool deferWebView)
+{
+    if (hidden) {
+        mLaunchedHidden = true;
+        mDeferWebView = deferWebView;
+        return;
+    }
+
+    if (!mLaunchedHidden)
+        return;
+
+    mLaunchedHidden = false;
+
+    if (!mWindow)
+        return;
+
+    // The container only creates the web view once we're visible, so there
+    // is nothing to wait for
+    if (mDeferWebView && !mWebView) {
+        mWindow->show();
+        return;
+    }
+
+    // Otherwise the page was prepared in the background and the usual rules
+    // apply; if it isn't ready yet it gets shown once it is
+    if (mStageReady)
+        showWhenPainted();
+}
+
+bool WebApplicationWindow::deferWebView() const
+{
+    return mDeferWebView;
+}
+
+void WebApplicationWindow::setShowOnFirstPaint(bool enabled)
+{
+    sShowOnFirstPaint = enabled;
+}
+
+void WebApplicationWindow::setResourceReleaseDelay(int delay)
+{
+    sResourceReleaseDelay = delay;
+}
+
+bool WebApplicationWindow::resourcesReleased() const
+{
+    return mResourcesReleased;
+}
+
+QString WebApplicationWindow::snapshotPath(const QString &name)
+{
+    QString cacheHome = qgetenv("XDG_CACHE_HOME");
+    if (cacheHome.isEmpty())
+        return QString();
+
+    QString directory = QString("%1/LunaWebAppMgr/snapshots").arg(cacheHome);
+    QDir().mkpath(directory);
+
+    return QString("%1/%2.png").arg(directory).arg(name);
+}
+
+bool WebApplicationWindow::saveSnapshot(const QString &path)
+{
+    if (!mWindow || path.isEmpty())
+        return false;
+
+    QImage snapshot = mWindow->grabWindow();
+    if (snapshot.isNull() || !snapshot.save(path)) {
+        qWarning() << "Failed to save snapshot of app" << mApplication->id();
+        return false;
+    }
+
+    return true;
+}
+
+void WebApplicationWindow::onReleaseResources()
+{
+    if (!mWindow || mWindow->isVisible() || mResourcesReleased)
+        return;
+
+    // The card switcher still wants to show something for us so leave it a
+    // picture of the last content before everything is thrown away
+    QString path = snapshotPath(QString("%1-%2").arg(mApplication->id()).arg(mWindowId));
+    if (saveSnapshot(path)) {
+        mSnapshotPath = path;
+        setWindowProperty(QString("_LUNE_WINDOW_SNAPSHOT"), QVariant(mSnapshotPath));
+    }
+
+    qint64 residentBefore = residentMemory(getpid());
+
+    // The platform window itself stays as the compositor identifies the card
+    // by its surface, everything rendering related gets dropped though
+    mWindow->setPersistentOpenGLContext(false);
+    mWindow->setPersistentSceneGraph(false);
+    mWindow->releaseResources();
+
+    mResourcesReleased = true;
+
+    // The render thread cleans up asynchronously so measure a bit later
+    QTimer::singleShot(RESOURCE_RELEASE_MEASURE_DELAY, this, [=]() {
+        qCDebug(lcMemory) << "Releasing rendering resources of hidden app" << mApplication->id()
+                          << "saved" << residentBefore - residentMemory(getpid()) << "kB";
+    });
+}
+
+void WebApplicationWindow::restoreResources()
+{
+    mReleaseTimer.stop();
+
+    if (!mResourcesReleased)
+        return;
+
+    qCDebug(lcWindow) << "Restoring rendering resources of app" << mApplication->id();
+
+    // Everything else is rebuilt by the scene graph once we're exposed again
+    mWindow->setPersistentOpenGLContext(true);
+    mWindow->setPersistentSceneGraph(true);
+
+    setWindowProperty(QString("_LUNE_WINDOW_SNAPSHOT"), QVariant(QString()));
+    if (!mSnapshotPath.isEmpty()) {
+        QFile::remove(mSnapshotPath);
+        mSnapshotPath.clear();
+    }
+
+    mResourcesReleased = false;
+}
+
+void WebApplicationWindow::onFrameSwapped()
+{
+    // We're only interested in the first frame here
+    disconnect(mWindow, SIGNAL(frameSwapped()), this, SLOT(onFrameSwapped()));
+
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+
+    emit firstFrameSwapped();
+}
+
+void WebApplicationWindow::onSceneGraphError(QQuickWindow::SceneGraphError error, const QString &message)
+{
+    qWarning() << "Failed to render window of app" << mApplication->id() << ":" << error << message;
+}
+
 void WebApplicationWindow::setupPage()
 {
     qreal zoomFactor = Settings::LunaSettings()->layoutScale;
@@ -283,7 +630,7 @@ void WebApplicationWindow::setupPage()
 
 void WebApplicationWindow::notifyAppAboutFocusState(bool focus)
 {
-    qDebug() << "DEBUG: We become" << (focus ? "focused" : "unfocused");
+    qCDebug(lcWindow) << "DEBUG: We become" << (focus ? "focused" : "unfocused");
 
     QString action = focus ? "stageActivated" : "stageDeactivated";
 
@@ -297,7 +644,7 @@ void WebApplicationWindow::notifyAppAboutFocusState(bool focus)
 
 void WebApplicationWindow::onLoadingChanged(QWebLoadRequest *request)
 {
-    qDebug() << Q_FUNC_INFO << "id" << mApplication->id() << "status" << request->status();
+    qCDebug(lcWindow) << Q_FUNC_INFO << "id" << mApplication->id() << "status" << request->status();
 
     switch (request->status()) {
     case QQuickWebView::LoadStartedStatus:
@@ -305,6 +652,7 @@ void WebApplicationWindow::onLoadingChanged(QWebLoadRequest *request)
         return;
     case QQuickWebView::LoadStoppedStatus:
     case QQuickWebView::LoadFailedStatus:
+        emit loadFailed();
         return;
     case QQuickWebView::LoadSucceededStatus:
         break;
@@ -313,6 +661,8 @@ void WebApplicationWindow::onLoadingChanged(QWebLoadRequest *request)
     Q_FOREACH(BaseExtension *extension, mExtensions.values())
         extension->initialize();
 
+    emit loadSucceeded();
+
     // If we're a headless app we don't show the window and in case of an
     // application with an remote entry point it's already visible at
     // this point
@@ -321,19 +671,22 @@ void WebApplicationWindow::onLoadingChanged(QWebLoadRequest *request)
 
     // if the framework  called us with an explicit stagePreparing call we
     // will wait for the call to stageReady to come in
+    mLoadSucceededTime.start();
+
     if (mStagePreparing && !mStageReady) {
         if (!mWindow->isVisible() && !mStageReadyTimer.isActive()) {
-            qDebug() << Q_FUNC_INFO << "id" << mApplication->id() << "kicking stage ready timer";
-            mStageReadyTimer.start(3000);
+            int timeout = stageReadyTimeout();
+            qCDebug(lcWindow) << Q_FUNC_INFO << "id" << mApplication->id() << "kicking stage ready timer with" << timeout << "ms";
+            mStageReadyOverdue = false;
+            mStageReadyTimer.start(timeout);
         }
         else {
-            qDebug() << Q_FUNC_INFO << "id" << mApplication->id() << "omitting stage ready timer as alreay active or window visible";
+            qCDebug(lcWindow) << Q_FUNC_INFO << "id" << mApplication->id() << "omitting stage ready timer as alreay active or window visible";
         }
         return;
     }
 
-    if (!mWindow->isVisible())
-        mWindow->show();
+    showWhenPainted();
 }
 
 #ifndef WITH_UNMODIFIED_QTWEBKIT
@@ -345,43 +698,26 @@ void WebApplicationWindow::onCreateNewPage(QWebNewPageRequest *request)
 
 void WebApplicationWindow::onClosePage()
 {
-    qDebug() << __PRETTY_FUNCTION__;
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__;
     mApplication->closeWindow(this);
 }
 
 void WebApplicationWindow::onSyncMessageReceived(const QVariantMap& message, QString& response)
 {
-    if (!message.contains("data"))
-        return;
-
-    QString data = message.value("data").toString();
-
-    QJsonDocument document = QJsonDocument::fromJson(data.toUtf8());
-
-    if (!document.isObject())
-        return;
-
-    QJsonObject rootObject = document.object();
-
-    QString messageType;
-    if (!rootObject.contains("messageType") || !rootObject.value("messageType").isString())
-        return;
+    QString extensionName;
+    QString funcName;
+    QJsonArray params;
 
-    messageType = rootObject.value("messageType").toString();
-    if (messageType != "callSyncExtensionFunction")
+    if (!parseSyncExtensionCall(message, extensionName, funcName, params))
         return;
 
-    if (!(rootObject.contains("extension") && rootObject.value("extension").isString()) ||
-        !(rootObject.contains("func") && rootObject.value("func").isString()) ||
-        !(rootObject.contains("params") && rootObject.value("params").isArray()))
+    if (!mExtensions.contains(extensionName))
         return;
 
-    QString extensionName = rootObject.value("extension").toString();
-    QString funcName = rootObject.value("func").toString();
-    QJsonArray params = rootObject.value("params").toArray();
+    qCDebugForApp(lcBridge, mApplication->id()) << "Synchronous call" << extensionName << funcName
+                                                << "from app" << mApplication->id();
 
-    if (!mExtensions.contains(extensionName))
-        return;
+    Watchdog::Scope watchdog("bridge", extensionName, funcName);
 
     BaseExtension *extension = mExtensions.value(extensionName);
     response = extension->handleSynchronousCall(funcName, params);
@@ -396,18 +732,32 @@ void WebApplicationWindow::createDefaultExtensions()
 
     if (mApplication->id() == "org.webosports.app.settings")
         addExtension(new WiFiManager(this));
+
+    QString pluginName = mApplication->desc().pluginName();
+    if (!pluginName.isEmpty())
+        loadApplicationPlugin(pluginName);
+}
+
+void WebApplicationWindow::loadApplicationPlugin(const QString &name)
+{
+    mPlugin = WebApplicationPluginCache::instance()->acquire(name);
+    if (!mPlugin)
+        return;
+
+    Q_FOREACH(BaseExtension *extension, mPlugin->createExtensions(this))
+        addExtension(extension);
 }
 
 void WebApplicationWindow::addExtension(BaseExtension *extension)
 {
-    qDebug() << "Adding extension" << extension->name();
+    qCDebug(lcExtensions) << "Adding extension" << extension->name();
     mExtensions.insert(extension->name(), extension);
 }
 
 void WebApplicationWindow::loadAllExtensions()
 {
     foreach(BaseExtension *extension, mExtensions.values()) {
-        qDebug() << "Initializing extension" << extension->name();
+        qCDebug(lcExtensions) << "Initializing extension" << extension->name();
         emit extensionWantsToBeAdded(extension->name(), extension);
     }
 }
@@ -441,14 +791,14 @@ QString WebApplicationWindow::getIdentifierForFrame(const QString& id, const QSt
     if (url.startsWith("file:///usr/palm/applications/com.palm.systemui"))
         identifier = QString("com.palm.systemui %1").arg(mApplication->processId());
 
-    qDebug() << __PRETTY_FUNCTION__ << "Decided identifier for frame" << id << "is" << identifier;
+    qCDebugForApp(lcBridge, mApplication->id()) << __PRETTY_FUNCTION__ << "Decided identifier for frame" << id << "is" << identifier;
 
     return identifier;
 }
 
 void WebApplicationWindow::stagePreparing()
 {
-    qDebug() << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
 
     mStagePreparing = true;
     emit readyChanged();
@@ -456,17 +806,20 @@ void WebApplicationWindow::stagePreparing()
 
 void WebApplicationWindow::stageReady()
 {
-    qDebug() << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+
+    if (mStageReadyTimer.isActive() || mStageReadyOverdue) {
+        mStageReadyTimer.stop();
+        mStageReadyOverdue = false;
+        ApplicationHistory::instance()->recordStageReady(mApplication->id(), mLoadSucceededTime.elapsed());
+    }
 
     mStagePreparing = false;
     mStageReady = true;
 
-    if (mWindow && !mLaunchedHidden && !mWindow->isVisible())
-        mWindow->show();
+    showWhenPainted();
 
     emit readyChanged();
-
-    mStageReadyTimer.stop();
 }
 
 void WebApplicationWindow::show()
@@ -474,8 +827,11 @@ void WebApplicationWindow::show()
     if (!mWindow)
         return;
 
-    qDebug() << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
 
+    mLaunchedHidden = false;
+
+    restoreResources();
     mWindow->show();
 }
 
@@ -484,7 +840,7 @@ void WebApplicationWindow::hide()
     if (!mWindow)
         return;
 
-    qDebug() << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
 
     mWindow->hide();
 }
@@ -494,7 +850,11 @@ void WebApplicationWindow::focus()
     if (!mWindow)
         return;
 
-    qDebug() << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+
+    restoreResources();
+
+    mLaunchedHidden = false;
 
     /* When we're closed we have to make sure we're visible before
      * raising ourself */
@@ -509,13 +869,17 @@ void WebApplicationWindow::unfocus()
     if (!mWindow)
         return;
 
-    qDebug() << __PRETTY_FUNCTION__ << "id" << mApplication->id();
+    qCDebug(lcWindow) << __PRETTY_FUNCTION__ << "id" << mApplication->id();
 
     mWindow->lower();
 }
 
 void WebApplicationWindow::executeScript(const QString &script)
 {
+    FrameStatistics::WorkScope work(FrameStatistics::WorkScript);
+
+    qCDebugForApp(lcBridge, mApplication->id()) << "Executing script for app" << mApplication->id() << script;
+
     emit javaScriptExecNeeded(script);
 }
 
@@ -628,6 +992,32 @@ QQuickItem* WebApplicationWindow::rootItem() const
     return mRootItem;
 }
 
+FrameStatistics* WebApplicationWindow::frameStatistics() const
+{
+    return mFrameStatistics;
+}
+
+RenderProfile* WebApplicationWindow::renderProfile() const
+{
+    return mRenderProfile;
+}
+
+void WebApplicationWindow::setRenderProfile(const QString &name)
+{
+    // The surface format can't be changed anymore once the window exists
+    if (mWindow) {
+        qWarning() << "Can't change the render profile of a window already created";
+        return;
+    }
+
+    qCDebug(lcWindow) << "Using render profile" << name << "for app" << mApplication->id();
+
+    delete mRenderProfile;
+    mRenderProfile = new RenderProfile(name, this);
+
+    emit renderProfileChanged();
+}
+
 bool WebApplicationWindow::hasFocus() const
 {
     if (!mWindow)
@@ -22,6 +22,7 @@
 #include <QQmlApplicationEngine>
 #include <QQuickWindow>
 #include <QTimer>
+#include <QElapsedTimer>
 
 #include <QtWebKit/private/qquickwebview_p.h>
 #ifndef WITH_UNMODIFIED_QTWEBKIT
@@ -31,6 +32,10 @@
 
 #include <applicationenvironment.h>
 
+#include "renderprofile.h"
+#include "windowproperties.h"
+
+class QQmlContext;
 class QQuickView;
 class QQuickItem;
 
@@ -39,6 +44,8 @@ namespace luna
 
 class BaseExtension;
 class WebApplication;
+class WebApplicationPlugin;
+class FrameStatistics;
 
 enum TrustScope
 {
@@ -59,6 +66,8 @@ class WebApplicationWindow : public ApplicationEnvironment
     Q_PROPERTY(QString windowType READ windowType CONSTANT)
     Q_PROPERTY(bool visible READ visible NOTIFY visibleChanged)
     Q_PROPERTY(bool focus READ hasFocus NOTIFY focusChanged)
+    Q_PROPERTY(RenderProfile *renderProfile READ renderProfile NOTIFY renderProfileChanged)
+    Q_PROPERTY(bool deferWebView READ deferWebView CONSTANT)
 
 public:
     explicit WebApplicationWindow(WebApplication *application, const QUrl& url, const QString& windowType,
@@ -67,6 +76,10 @@ public:
 
     WebApplication *application() const;
 
+    void createPlatformWindow();
+    bool loadContainer();
+    bool createAndSetup();
+
     void stagePreparing();
     void stageReady();
 
@@ -89,6 +102,10 @@ public:
     QString windowType() const;
     bool visible() const;
     bool hasFocus() const;
+    RenderProfile* renderProfile() const;
+    FrameStatistics* frameStatistics() const;
+
+    void setRenderProfile(const QString &name);
 
     QQmlEngine* qmlEngine() const;
     QQuickItem* rootItem() const;
@@ -104,6 +121,18 @@ public:
 
     void clearMemoryCaches();
 
+    bool saveSnapshot(const QString &path);
+    bool resourcesReleased() const;
+
+    static QString snapshotPath(const QString &name);
+    static void setResourceReleaseDelay(int delay);
+    static void setShowOnFirstPaint(bool enabled);
+
+    void setLaunchedHidden(bool hidden, bool deferWebView = false);
+
+    void releaseWebView();
+    bool deferWebView() const;
+
     void destroy();
 
     Q_INVOKABLE void configureWebView(QQuickItem *webViewItem);
@@ -117,6 +146,10 @@ Q_SIGNALS:
     void urlChanged();
     void visibleChanged();
     void focusChanged();
+    void loadSucceeded();
+    void loadFailed();
+    void firstFrameSwapped();
+    void renderProfileChanged();
 
 protected:
     bool eventFilter(QObject *object, QEvent *event);
@@ -129,13 +162,21 @@ private Q_SLOTS:
 #endif
     void onLoadingChanged(QWebLoadRequest *request);
     void onStageReadyTimeout();
+    void onFirstPaintTimeout();
+    void onLoadVisuallyCommitted();
     void onVisibleChanged(bool visible);
-    void onWindowPropertyChanged(QPlatformWindow *window, const QString &name);
+    void onFrameSwapped();
+    void onReleaseResources();
+    void onSceneGraphError(QQuickWindow::SceneGraphError error, const QString &message);
 
 private:
+    friend class WindowPropertyDispatcher;
+
     WebApplication *mApplication;
     QMap<QString, BaseExtension*> mExtensions;
+    WebApplicationPlugin *mPlugin;
     QQmlEngine *mEngine;
+    QQmlContext *mContext;
     QQuickItem *mRootItem;
     QQuickView *mWindow;
     bool mHeadless;
@@ -146,6 +187,10 @@ private:
     bool mStagePreparing;
     bool mStageReady;
     QTimer mStageReadyTimer;
+    bool mStageReadyOverdue;
+    QElapsedTimer mLoadSucceededTime;
+    bool mFirstPaint;
+    QTimer mFirstPaintTimer;
     QList<QUrl> mUserScripts;
     QSize mSize;
     TrustScope mTrustScope;
@@ -153,18 +198,28 @@ private:
     int mParentWindowId;
     bool mLoadingAnimationDisabled;
     bool mLaunchedHidden;
+    bool mDeferWebView;
+    RenderProfile *mRenderProfile;
+    FrameStatistics *mFrameStatistics;
+    WindowProperties mProperties;
+    QTimer mReleaseTimer;
+    bool mResourcesReleased;
+    QString mSnapshotPath;
 
     void assignCorrectTrustScope();
-    void createAndSetup();
     void configureQmlEngine();
     void loadAllExtensions();
     void addExtension(BaseExtension *extension);
     void createDefaultExtensions();
+    void loadApplicationPlugin(const QString &name);
     void setWindowProperty(const QString &name, const QVariant &value);
     QVariant getWindowProperty(const QString &name);
     void updateWindowProperty(const QString &name);
     void setupPage();
     void notifyAppAboutFocusState(bool focus);
+    void restoreResources();
+    void showWhenPainted();
+    int stageReadyTimeout() const;
 };
 
 } // namespace luna
@@ -18,32 +18,86 @@
 #include <QDebug>
 #include <QDir>
 #include <QtWebKit/private/qquickwebview_p.h>
+#include <QThread>
 #include <QTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <systemd/sd-daemon.h>
+
+#include <LocalePreferences.h>
 
 #include "applicationdescription.h"
 #include "webappmanager.h"
 #include "webapplication.h"
+#include "webapplicationwindow.h"
 #include "webappmanagerservice.h"
+#include "lunaservicetransport.h"
+#include "webapplicationplugincache.h"
+#include "logging.h"
+#include "startupprofiler.h"
+#include "qmlcache.h"
+#include "memoryadmission.h"
+#include "teardownqueue.h"
+#include "applicationhistory.h"
+#include "tombstone.h"
+#include "windowpool.h"
+#include "framestatistics.h"
+#include "watchdog.h"
+#include "systemtime.h"
+#include "extensions/deviceinfo.h"
+
+#define WEBAPPMANAGER_SERVICE_ID    "org.webosports.webappmanager"
 
 namespace luna
 {
 
-WebAppManager::WebAppManager(int &argc, char **argv)
-    : QGuiApplication(argc, argv)
+WebAppManager::WebAppManager(int &argc, char **argv, ServiceTransport *transport)
+    : QGuiApplication(argc, argv),
+      mTransport(transport),
+      mScheduler(new LaunchScheduler(this)),
+      mAdmission(new MemoryAdmission(this)),
+      mTeardown(new TeardownQueue(this)),
+      mNotifySystemd(false),
+      mTombstoneEvicted(false),
+      mStallThreshold(0)
 {
+    StartupProfiler::instance()->mark("application");
+
     setApplicationName("LunaWebAppMgr");
     setQuitOnLastWindowClosed(false);
 
     QQuickWebViewExperimental::setFlickableViewportEnabled(false);
 
     connect(this, SIGNAL(aboutToQuit()), this, SLOT(onAboutToQuit()));
+    connect(&mFrameStatisticsTimer, SIGNAL(timeout()), this, SLOT(onLogFrameStatistics()));
+
+    WebApplicationPluginCache::instance()->buildIndex(WEBAPP_PLUGIN_DIR);
+
+    // Gathering the device information needs several calls into luna-prefs
+    // so do that in the background rather than on the first bridge call
+    DeviceInfo::prepareInBackground();
+
+    // The transport is only injected when driving the manager in-process,
+    // otherwise we're talking to the bus. Either way it's owned by us.
+    if (!mTransport)
+        mTransport = new LunaServiceTransport(WEBAPPMANAGER_SERVICE_ID);
+
+    mService = new WebAppManagerService(this, mTransport);
 
-    mService = new WebAppManagerService(this);
+    StartupProfiler::instance()->mark("service");
+
+    // Only once the event loop runs we're able to handle incoming service
+    // calls and can tell others about being ready
+    QMetaObject::invokeMethod(this, "onEventLoopStarted", Qt::QueuedConnection);
 }
 
 WebAppManager::~WebAppManager()
 {
     onAboutToQuit();
+
+    delete mService;
+    delete mTransport;
 }
 
 bool WebAppManager::validateApplication(const ApplicationDescription& desc)
@@ -57,7 +111,8 @@ bool WebAppManager::validateApplication(const ApplicationDescription& desc)
     return true;
 }
 
-WebApplication* WebAppManager::launchApp(const QString &appDesc, const QString &parameters, int64_t processId)
+WebApplication* WebAppManager::launchApp(const QString &appDesc, const QString &parameters, int64_t processId,
+                                         QString *errorText)
 {
     ApplicationDescription desc(appDesc);
 
@@ -67,9 +122,21 @@ WebApplication* WebAppManager::launchApp(const QString &appDesc, const QString &
         return NULL;
     }
 
+    if (mTombstones.contains(desc.id()) && !restoreTombstone(desc.id(), errorText))
+        return NULL;
+
+    // Launching a running application without asking for it to stay hidden
+    // brings up what was launched hidden before
+    if (mApplications.contains(desc.id()) && !desc.launchHidden())
+        mApplications.value(desc.id())->unhide();
+
+    if (mPendingLaunches.contains(desc.id()))
+        return mergePendingLaunch(desc.id(), parameters);
+
     if (mApplications.contains(desc.id())) {
         WebApplication *app = mApplications.value(desc.id());
-        app->relaunch(parameters);
+        if (!scheduleRelaunch(app, parameters, errorText))
+            return NULL;
         return app;
     }
 
@@ -80,19 +147,18 @@ WebApplication* WebAppManager::launchApp(const QString &appDesc, const QString &
     QUrl entryPoint = desc.entryPoint();
     WebApplication *app = new WebApplication(this, entryPoint, windowType,
                                              desc, parameters, processId);
-    connect(app, SIGNAL(closed()), this, SLOT(onApplicationClosed()));
 
     this->setQuitOnLastWindowClosed(false);
 
-    mApplications.insert(app->id(), app);
-
-    mService->notifyAppHasStarted(app->id(), app->processId());
+    if (!startApplication(app, launchPriority(desc, parameters), errorText))
+        return NULL;
 
     return app;
 }
 
 WebApplication* WebAppManager::launchUrl(const QUrl &url, const QString &windowType,
-                               const QString &appDesc, const QString &parameters, int64_t processId)
+                               const QString &appDesc, const QString &parameters, int64_t processId,
+                               QString *errorText)
 {
     ApplicationDescription desc(appDesc);
 
@@ -102,10 +168,20 @@ WebApplication* WebAppManager::launchUrl(const QUrl &url, const QString &windowT
         return NULL;
     }
 
+    if (mTombstones.contains(desc.id()) && !restoreTombstone(desc.id(), errorText))
+        return NULL;
+
+    if (mApplications.contains(desc.id()) && !desc.launchHidden())
+        mApplications.value(desc.id())->unhide();
+
+    if (mPendingLaunches.contains(desc.id()))
+        return mergePendingLaunch(desc.id(), parameters);
+
     // FIXME is this correct when launching an URL?
     if (mApplications.contains(desc.id())) {
         WebApplication *application = mApplications.value(desc.id());
-        application->relaunch(parameters);
+        if (!scheduleRelaunch(application, parameters, errorText))
+            return NULL;
         return application;
     }
 
@@ -113,17 +189,373 @@ WebApplication* WebAppManager::launchUrl(const QUrl &url, const QString &windowT
 
     WebApplication *app = new WebApplication(this, url, windowType, desc, parameters,
                                              processId);
+
+    if (!startApplication(app, launchPriority(desc, parameters), errorText))
+        return NULL;
+
+    return app;
+}
+
+LaunchScheduler::Priority WebAppManager::launchPriority(const ApplicationDescription &desc,
+                                                        const QString &parameters) const
+{
+    if (desc.id() == "com.palm.launcher")
+        return LaunchScheduler::PriorityLauncher;
+
+    // Nobody waits for applications which aren't shown anyway
+    if (desc.headless() || desc.launchHidden())
+        return LaunchScheduler::PriorityBackground;
+
+    // Applications started at boot are not something the user is waiting for
+    QJsonObject params = QJsonDocument::fromJson(parameters.toUtf8()).object();
+    if (params.value("launchedAtBoot").toBool(false))
+        return LaunchScheduler::PriorityBackground;
+
+    return LaunchScheduler::PriorityForeground;
+}
+
+bool WebAppManager::startApplication(WebApplication *app, LaunchScheduler::Priority priority,
+                                     QString *errorText)
+{
+    // The heavy parts of the construction happen over the next event loop
+    // iterations so the caller gets its response right away. Room for the
+    // application is made right before that, once it's its turn.
+    LaunchScheduler::Job job = [this, app]() {
+        mAdmission->admit(app);
+        app->launch();
+    };
+
+    if (!mScheduler->schedule(app->id(), priority, job, true)) {
+        if (errorText)
+            *errorText = "Too many pending launches, try again later";
+        delete app;
+        return false;
+    }
+
     connect(app, SIGNAL(closed()), this, SLOT(onApplicationClosed()));
+    connect(app, SIGNAL(launched()), this, SLOT(onApplicationLaunched()));
+    connect(app, SIGNAL(launchFailed()), this, SLOT(onApplicationLaunchFailed()));
+    connect(app, SIGNAL(loaded()), this, SLOT(onApplicationLoaded()));
+    connect(app, SIGNAL(loadFailed()), this, SLOT(onApplicationLoadFailed()));
 
     mApplications.insert(app->id(), app);
+    mPendingLaunches.insert(app->id(), app);
 
-    mService->notifyAppHasStarted(app->id(), app->processId());
+    return true;
+}
+
+WebApplication* WebAppManager::mergePendingLaunch(const QString &appId, const QString &parameters)
+{
+    WebApplication *app = mPendingLaunches.value(appId);
+
+    // The application delivers the parameters as relaunch once its page is
+    // loaded; the caller gets the same process as the initial one
+    qCDebug(lcLaunch) << "Merging launch request for" << appId << "into pending launch of process" << app->processId();
+
+    app->relaunch(parameters);
 
     return app;
 }
 
+bool WebAppManager::scheduleRelaunch(WebApplication *app, const QString &parameters, QString *errorText)
+{
+    if (!mScheduler->schedule(app->id(), LaunchScheduler::PriorityRelaunch,
+                              [app, parameters]() { app->relaunch(parameters); }, false)) {
+        if (errorText)
+            *errorText = "Too many pending launches, try again later";
+        return false;
+    }
+
+    return true;
+}
+
+void WebAppManager::onApplicationLoaded()
+{
+    WebApplication *app = static_cast<WebApplication*>(sender());
+
+    mPendingLaunches.remove(app->id());
+    mScheduler->finished(app->id());
+
+    mAdmission->applicationLoaded(app);
+}
+
+void WebAppManager::onApplicationLoadFailed()
+{
+    WebApplication *app = static_cast<WebApplication*>(sender());
+
+    qCWarning(lcLaunch) << "Page of application" << app->id() << "failed to load";
+
+    // Further launches go through the usual relaunch path rather than
+    // waiting for a page which isn't coming
+    mPendingLaunches.remove(app->id());
+    mScheduler->finished(app->id());
+}
+
+void WebAppManager::onApplicationLaunched()
+{
+    WebApplication *app = static_cast<WebApplication*>(sender());
+
+    qCDebug(lcLaunch) << "Application" << app->id() << "was launched";
+
+    // A deferred window doesn't load anything before it's shown, so there
+    // is no load to wait for, neither for the slot of the launch nor for
+    // further launch requests
+    if (app->mainWindow()->deferWebView()) {
+        mPendingLaunches.remove(app->id());
+        mScheduler->finished(app->id());
+    }
+
+    // For everyone else a restored application was running all the time;
+    // it only replaces its tombstone once it's ready or shown anyway, be it
+    // with its first paint or after the stage ready timeout
+    if (mTombstones.contains(app->id())) {
+        connect(app->mainWindow(), SIGNAL(readyChanged()), this, SLOT(onRestoredWindowReady()));
+        connect(app->mainWindow(), SIGNAL(visibleChanged()), this, SLOT(onRestoredWindowReady()));
+        return;
+    }
+
+    mService->notifyAppHasStarted(app->id(), app->processId());
+}
+
+bool WebAppManager::tombstoneApp(const QString &appId)
+{
+    WebApplication *app = mApplications.value(appId);
+    if (!app || !app->mainWindow() || app->launching() || app->headless() ||
+        mTombstones.contains(appId))
+        return false;
+
+    Tombstone *tombstone = new Tombstone(app, this);
+    connect(tombstone, SIGNAL(activated()), this, SLOT(onTombstoneActivated()));
+    connect(tombstone, SIGNAL(closed()), this, SLOT(onTombstoneClosed()));
+
+    // Has to be in place before the application goes away so nobody is told
+    // about it being finished
+    mTombstones.insert(appId, tombstone);
+
+    qCDebug(lcMemory) << "Evicting" << appId << "leaving a tombstone for" << tombstone->url();
+
+    app->kill();
+    tombstone->show();
+
+    return true;
+}
+
+void WebAppManager::evictApp(const QString &appId)
+{
+    if (mTombstoneEvicted && tombstoneApp(appId))
+        return;
+
+    killApp(appId);
+}
+
+bool WebAppManager::restoreTombstone(const QString &appId, QString *errorText)
+{
+    Tombstone *tombstone = mTombstones.value(appId);
+    if (tombstone->restoring())
+        return true;
+
+    qCDebug(lcMemory) << "Restoring" << appId << "from its tombstone";
+
+    WebApplication *app = new WebApplication(this, tombstone->url(), tombstone->windowType(),
+                                             tombstone->desc(), tombstone->parameters(),
+                                             tombstone->processId());
+
+    if (!startApplication(app, LaunchScheduler::PriorityForeground, errorText))
+        return false;
+
+    tombstone->setRestoring(true);
+
+    return true;
+}
+
+Tombstone* WebAppManager::takeTombstone(const QString &appId)
+{
+    Tombstone *tombstone = mTombstones.take(appId);
+
+    // We're possibly called from one of its signals
+    if (tombstone)
+        tombstone->deleteLater();
+
+    return tombstone;
+}
+
+void WebAppManager::closeTombstone(const QString &appId)
+{
+    Tombstone *tombstone = takeTombstone(appId);
+    if (!tombstone)
+        return;
+
+    // While being restored the application takes care of telling everyone
+    if (mApplications.contains(appId))
+        mApplications.value(appId)->kill();
+    else
+        mService->notifyAppHasFinished(appId, tombstone->processId());
+}
+
+void WebAppManager::onRestoredWindowReady()
+{
+    WebApplicationWindow *window = static_cast<WebApplicationWindow*>(sender());
+    if (!window->ready() && !window->visible())
+        return;
+
+    disconnect(window, 0, this, SLOT(onRestoredWindowReady()));
+
+    qCDebug(lcMemory) << "Swapping in restored application" << window->application()->id();
+
+    takeTombstone(window->application()->id());
+    window->focus();
+}
+
+void WebAppManager::onTombstoneActivated()
+{
+    Tombstone *tombstone = static_cast<Tombstone*>(sender());
+
+    if (!restoreTombstone(tombstone->appId(), 0))
+        qWarning("Failed to restore application %s", tombstone->appId().toUtf8().constData());
+}
+
+void WebAppManager::onTombstoneClosed()
+{
+    Tombstone *tombstone = static_cast<Tombstone*>(sender());
+
+    closeTombstone(tombstone->appId());
+}
+
+void WebAppManager::onApplicationLaunchFailed()
+{
+    WebApplication *app = static_cast<WebApplication*>(sender());
+
+    qWarning("Failed to launch application %s", app->id().toUtf8().constData());
+
+    mApplications.remove(app->id());
+    mPendingLaunches.remove(app->id());
+    mScheduler->cancel(app->id());
+    mAdmission->applicationClosed(app);
+    takeTombstone(app->id());
+
+    mService->notifyAppLaunchFailed(app->id(), app->processId());
+
+    app->deleteLater();
+}
+
+void WebAppManager::setNotifySystemd(bool notify)
+{
+    mNotifySystemd = notify;
+}
+
+void WebAppManager::setTrafficRecordFile(const QString &path)
+{
+    if (path.isEmpty())
+        mService->stopRecording();
+    else
+        mService->startRecording(path);
+}
+
+void WebAppManager::setTombstoneEvicted(bool enabled)
+{
+    mTombstoneEvicted = enabled;
+}
+
+void WebAppManager::setFrameStatisticsInterval(int interval)
+{
+    if (interval <= 0) {
+        mFrameStatisticsTimer.stop();
+        return;
+    }
+
+    // Asking for the statistics to be logged implies wanting to see them
+    setLogLevel("frames", "debug");
+
+    mFrameStatisticsTimer.start(interval);
+}
+
+void WebAppManager::onLogFrameStatistics()
+{
+    Q_FOREACH(WebApplication *app, mApplications) {
+        Q_FOREACH(WebApplicationWindow *window, app->windows()) {
+            if (!window->frameStatistics())
+                continue;
+
+            qCDebug(lcFrames).noquote() << app->id() << window->windowType()
+                                        << window->frameStatistics()->summary();
+        }
+    }
+}
+
+void WebAppManager::setStallThreshold(int threshold)
+{
+    mStallThreshold = threshold;
+}
+
+bool WebAppManager::notify(QObject *receiver, QEvent *event)
+{
+    // Only the GUI thread is watched; events delivered on other threads
+    // would just overwrite what it's busy with
+    if (QThread::currentThread() != thread())
+        return QGuiApplication::notify(receiver, event);
+
+    // Lets a stall be blamed on the event when no more specific handler
+    // is known
+    Watchdog::EventScope scope(receiver, event);
+
+    return QGuiApplication::notify(receiver, event);
+}
+
+void WebAppManager::setResourceReleaseDelay(int delay)
+{
+    WebApplicationWindow::setResourceReleaseDelay(delay);
+}
+
+void WebAppManager::setShowOnFirstPaint(bool enabled)
+{
+    WebApplicationWindow::setShowOnFirstPaint(enabled);
+}
+
+void WebAppManager::onEventLoopStarted()
+{
+    StartupProfiler *profiler = StartupProfiler::instance();
+    profiler->mark("eventloop");
+
+    QString summary = profiler->summary();
+    qCDebug(lcLaunch) << summary;
+
+    if (mNotifySystemd)
+        sd_notifyf(0, "READY=1\nSTATUS=%s", summary.toUtf8().constData());
+
+    // Startup itself is allowed to block, only watch from here on
+    uint64_t watchdogInterval = 0;
+    if (!mNotifySystemd || sd_watchdog_enabled(0, &watchdogInterval) <= 0)
+        watchdogInterval = 0;
+
+    if (mStallThreshold > 0 || watchdogInterval > 0)
+        Watchdog::instance()->enable(mStallThreshold, watchdogInterval);
+
+    // Everything not needed to handle the first launch is initialized
+    // once the queued up events are processed
+    QTimer::singleShot(0, this, SLOT(onInitializeDeferred()));
+}
+
+void WebAppManager::onInitializeDeferred()
+{
+    LocalePreferences::instance();
+    SystemTime::instance();
+
+    // Only does something when the cache for this build is still empty
+    QmlCache::instance()->warmUp();
+
+    StartupProfiler::instance()->mark("deferred");
+}
+
 void WebAppManager::onAboutToQuit()
 {
+    // Keep what was learned about the still running applications
+    Q_FOREACH(WebApplication *app, mApplications)
+        mAdmission->applicationClosed(app);
+
+    ApplicationHistory::instance()->flush();
+    mTeardown->flush();
+    WindowPool::instance()->clear();
+    Watchdog::instance()->stop();
 }
 
 void WebAppManager::onApplicationClosed()
@@ -136,17 +568,38 @@ void WebAppManager::onApplicationClosed()
     }
 
     mApplications.remove(app->id());
+    mPendingLaunches.remove(app->id());
+    mScheduler->cancel(app->id());
+    mAdmission->applicationClosed(app);
+
+    // Evicted applications are still around for everyone else, unless they
+    // went away again while being restored
+    Tombstone *tombstone = mTombstones.value(app->id());
+    if (tombstone && tombstone->restoring()) {
+        takeTombstone(app->id());
+        tombstone = 0;
+    }
 
-    mService->notifyAppHasFinished(app->id(), app->processId());
+    if (!tombstone)
+        mService->notifyAppHasFinished(app->id(), app->processId());
 
-    qDebug() << "Application" << app->id() << "was closed";
-    delete app;
+    qCDebug(lcLaunch) << "Application" << app->id() << "was closed";
+
+    // Whatever the application still does until it's gone is of no
+    // interest anymore
+    disconnect(app, 0, this, 0);
+    mTeardown->schedule(app);
 }
 
 void WebAppManager::killApp(const QString &appId)
 {
     WebApplication *appToKill = 0;
 
+    if (mTombstones.contains(appId)) {
+        closeTombstone(appId);
+        return;
+    }
+
     Q_FOREACH(WebApplication *app, mApplications) {
         if (app->id() == appId) {
             appToKill = app;
@@ -162,6 +615,13 @@ void WebAppManager::killApp(int64_t processId)
 {
     WebApplication *appToKill = 0;
 
+    Q_FOREACH(Tombstone *tombstone, mTombstones) {
+        if (tombstone->processId() == processId) {
+            closeTombstone(tombstone->appId());
+            return;
+        }
+    }
+
     Q_FOREACH(WebApplication *app, mApplications) {
         if (app->processId() == processId) {
             appToKill = app;
@@ -173,9 +633,26 @@ void WebAppManager::killApp(int64_t processId)
         appToKill->kill();
 }
 
+QStringList WebAppManager::closeApps(const QStringList &appIds)
+{
+    QStringList closed;
+
+    // All of them are hidden right away but taken apart one step at a
+    // time, so this is cheap even for many applications
+    Q_FOREACH(const QString &appId, appIds) {
+        if (!isAppRunning(appId))
+            continue;
+
+        killApp(appId);
+        closed.append(appId);
+    }
+
+    return closed;
+}
+
 bool WebAppManager::isAppRunning(const QString &appId)
 {
-    return mApplications.contains(appId);
+    return mApplications.contains(appId) || mTombstones.contains(appId);
 }
 
 QList<WebApplication*> WebAppManager::applications() const
@@ -183,10 +660,13 @@ QList<WebApplication*> WebAppManager::applications() const
     return mApplications.values();
 }
 
-bool WebAppManager::relaunch(const QString &appId, const QString &params)
+bool WebAppManager::relaunch(const QString &appId, const QString &params, QString *errorText)
 {
     WebApplication *targetApp = 0;
 
+    if (mTombstones.contains(appId) && !restoreTombstone(appId, errorText))
+        return false;
+
     Q_FOREACH(WebApplication *app, mApplications) {
         if (app->id() == appId) {
             targetApp = app;
@@ -197,9 +677,7 @@ bool WebAppManager::relaunch(const QString &appId, const QString &params)
     if (!targetApp)
         return false;
 
-    targetApp->relaunch(params);
-
-    return true;
+    return scheduleRelaunch(targetApp, params, errorText);
 }
 
 void WebAppManager::clearMemoryCaches()
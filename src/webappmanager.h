@@ -26,6 +26,9 @@
 #include <QFile>
 #include <QTextStream>
 #include <QStringList>
+#include <QTimer>
+
+#include "launchscheduler.h"
 
 namespace luna
 {
@@ -33,23 +36,33 @@ namespace luna
 class ApplicationDescription;
 class WebApplication;
 class WebAppManagerService;
+class ServiceTransport;
+class MemoryAdmission;
+class TeardownQueue;
+class Tombstone;
 
 class WebAppManager : public QGuiApplication
 {
     Q_OBJECT
 
 public:
-    WebAppManager(int& argc, char **argv);
+    WebAppManager(int& argc, char **argv, ServiceTransport *transport = 0);
     virtual ~WebAppManager();
 
-    WebApplication* launchApp(const QString &appDesc, const QString &parameters, int64_t processId);
+    WebApplication* launchApp(const QString &appDesc, const QString &parameters, int64_t processId,
+                              QString *errorText = 0);
     WebApplication* launchUrl(const QUrl &url, const QString &windowType,
-                              const QString &appDesc, const QString &parameters, int64_t processId);
+                              const QString &appDesc, const QString &parameters, int64_t processId,
+                              QString *errorText = 0);
 
     bool isAppRunning(const QString& appId);
     void killApp(const QString& appId);
     void killApp(int64_t processId);
-    bool relaunch(const QString& appId, const QString& params);
+    QStringList closeApps(const QStringList &appIds);
+    bool relaunch(const QString& appId, const QString& params, QString *errorText = 0);
+
+    bool tombstoneApp(const QString &appId);
+    void evictApp(const QString &appId);
 
     QList<WebApplication*> applications() const;
 
@@ -57,15 +70,53 @@ public:
     void clearMemoryCaches(qint64 processId);
     void clearMemoryCaches(const QString& appId);
 
+    void setNotifySystemd(bool notify);
+    void setTrafficRecordFile(const QString &path);
+    void setResourceReleaseDelay(int delay);
+    void setShowOnFirstPaint(bool enabled);
+    void setTombstoneEvicted(bool enabled);
+    void setFrameStatisticsInterval(int interval);
+    void setStallThreshold(int threshold);
+
+    bool notify(QObject *receiver, QEvent *event);
+
 private Q_SLOTS:
     void onApplicationClosed();
+    void onApplicationLaunched();
+    void onApplicationLaunchFailed();
+    void onApplicationLoaded();
+    void onApplicationLoadFailed();
+    void onRestoredWindowReady();
+    void onTombstoneActivated();
+    void onTombstoneClosed();
+    void onLogFrameStatistics();
     void onAboutToQuit();
+    void onEventLoopStarted();
+    void onInitializeDeferred();
 
 private:
+    ServiceTransport *mTransport;
     WebAppManagerService *mService;
+    LaunchScheduler *mScheduler;
+    MemoryAdmission *mAdmission;
+    TeardownQueue *mTeardown;
+    bool mNotifySystemd;
+    bool mTombstoneEvicted;
+    int mStallThreshold;
+    QTimer mFrameStatisticsTimer;
     QMap<QString,WebApplication*> mApplications;
+    QMap<QString,WebApplication*> mPendingLaunches;
+    QMap<QString,Tombstone*> mTombstones;
 
     bool validateApplication(const ApplicationDescription& desc);
+    bool startApplication(WebApplication *app, LaunchScheduler::Priority priority, QString *errorText);
+    WebApplication* mergePendingLaunch(const QString &appId, const QString &parameters);
+    bool scheduleRelaunch(WebApplication *app, const QString &parameters, QString *errorText);
+    bool restoreTombstone(const QString &appId, QString *errorText);
+    void closeTombstone(const QString &appId);
+    Tombstone* takeTombstone(const QString &appId);
+    LaunchScheduler::Priority launchPriority(const ApplicationDescription &desc,
+                                             const QString &parameters) const;
 };
 
 } // namespace luna
@@ -24,44 +24,93 @@
 #include "webappmanager.h"
 #include "webappmanagerservice.h"
 #include "lunaserviceutils.h"
+#include "logging.h"
+#include "webapplicationwindow.h"
+#include "framestatistics.h"
+#include "watchdog.h"
 
-#define WEBAPPMANAGER_SERVICE_ID    "org.webosports.webappmanager"
+#define SERVICE_METHOD(name) \
+    mTransport->registerMethod(#name, [this](ServiceRequest &request) { \
+        return dispatch(#name, request, &WebAppManagerService::name); })
 
 namespace luna
 {
 
+// The launch request can ask for a hidden launch on its own, which takes
+// precedence over what the application description says
+static QJsonObject applyLaunchOptions(QJsonObject appDesc, const QJsonObject &request)
+{
+    if (request.contains("launchHidden") && request.value("launchHidden").isBool())
+        appDesc.insert("launchHidden", request.value("launchHidden"));
+
+    if (request.contains("hiddenLaunchMode") && request.value("hiddenLaunchMode").isString())
+        appDesc.insert("hiddenLaunchMode", request.value("hiddenLaunchMode"));
+
+    return appDesc;
+}
+
 /*! \page org_webosports_webappmanager Service API org.webosports.webappmanager
  *
  * Public methods:
  * - \ref org_webosports_webappmanager_launch_app
  * - \ref org_webosports_webappmanager_launch_url
  * - \ref org_webosports_webappmanager_kill_app
+ * - \ref org_webosports_webappmanager_close_apps
  * - \ref org_webosports_webappmanager_is_app_running
  * - \ref org_webosports_webappmanager_list_running_apps
+ * - \ref org_webosports_webappmanager_set_log_level
  */
 
-WebAppManagerService::WebAppManagerService(WebAppManager *webAppManager)
-    : LS::Handle(LS::registerService(WEBAPPMANAGER_SERVICE_ID, false)),
-      mWebAppManager(webAppManager)
+WebAppManagerService::WebAppManagerService(WebAppManager *webAppManager, ServiceTransport *transport)
+    : mWebAppManager(webAppManager),
+      mTransport(transport)
+{
+    SERVICE_METHOD(launchApp);
+    SERVICE_METHOD(launchUrl);
+    SERVICE_METHOD(killApp);
+    SERVICE_METHOD(closeApps);
+    SERVICE_METHOD(isAppRunning);
+    SERVICE_METHOD(listRunningApps);
+    SERVICE_METHOD(registerForAppEvents);
+    SERVICE_METHOD(relaunch);
+    SERVICE_METHOD(clearMemoryCaches);
+    SERVICE_METHOD(setLogLevel);
+    SERVICE_METHOD(getFrameStatistics);
+    SERVICE_METHOD(getStallStatistics);
+
+    mTransport->start();
+}
+
+WebAppManagerService::~WebAppManagerService()
+{
+}
+
+bool WebAppManagerService::dispatch(const char *method, ServiceRequest &request,
+                                    bool (WebAppManagerService::*handler)(ServiceRequest&))
 {
-    attachToLoop(g_main_loop_new(g_main_context_default(), FALSE));
+    FrameStatistics::WorkScope work(FrameStatistics::WorkService);
+    Watchdog::Scope watchdog("service", method);
 
-    LS_CATEGORY_BEGIN(WebAppManagerService, "/")
-        LS_CATEGORY_METHOD(launchApp)
-        LS_CATEGORY_METHOD(launchUrl)
-        LS_CATEGORY_METHOD(killApp)
-        LS_CATEGORY_METHOD(isAppRunning)
-        LS_CATEGORY_METHOD(listRunningApps)
-        LS_CATEGORY_METHOD(registerForAppEvents)
-        LS_CATEGORY_METHOD(relaunch)
-        LS_CATEGORY_METHOD(clearMemoryCaches)
-    LS_CATEGORY_END
+    if (!mRecorder.isRecording())
+        return (this->*handler)(request);
 
-    mAppEventSubscriptions.setServiceHandle(this);
+    qint64 arrival = mRecorder.elapsed();
+    bool result = (this->*handler)(request);
+    qint64 latency = mRecorder.elapsed() - arrival;
+
+    mRecorder.record(method, request.isSubscription(), request.payload(), arrival, latency);
+
+    return result;
 }
 
-WebAppManagerService::~WebAppManagerService()
+bool WebAppManagerService::startRecording(const QString &path)
+{
+    return mRecorder.start(path);
+}
+
+void WebAppManagerService::stopRecording()
 {
+    mRecorder.stop();
 }
 
 /*!
@@ -75,19 +124,30 @@ org.webosports.webappmanager/launchApp
 
 Launch an web application.
 
+The call returns as soon as the request is validated. The application is
+constructed afterwards; subscribers of registerForAppEvents get a \c start
+event once that finished or a \c launchFailed event if it didn't work out.
+
 \subsection org_webosports_webappmanager_launch_app_syntax Syntax:
 \code
 {
     "appDesc": string,
     "params": string,
     "launchingAppId": string,
-    "launchingProcId": string
+    "launchingProcId": string,
+    "launchHidden": boolean,
+    "hiddenLaunchMode": string
 }
 \endcode
 
 \param appDesc Application description
 \param params Application parameters
 \param launchingAppId Application id of the application launching the new one
+\param launchHidden Optional. Start the application without showing its window until
+    it's launched again without this flag. Overrides the \c launchHidden field of the
+    application description, which defaults to true only for the launcher.
+\param hiddenLaunchMode Optional. Either \c defer to not create the web view before the
+    window is shown (default) or \c preload to load the page in the background.
 
 \subsection org_webosports_webappmanager_launch_app_returns Returns:
 \code
@@ -123,11 +183,11 @@ Example response for a failed call:
 }
 \endcode
 */
-bool WebAppManagerService::launchApp(LSMessage &message)
+bool WebAppManagerService::launchApp(ServiceRequest &request)
 {
-    LS::Message request(&message);
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
 
-    QByteArray payload(request.getPayload());
+    QByteArray payload = request.payload();
     if (payload.isEmpty()) {
         request.respond("{\"returnValue\":false,\"errorText\":\"Bad JSON\"}");
         return true;
@@ -150,7 +210,7 @@ bool WebAppManagerService::launchApp(LSMessage &message)
         return true;
     }
 
-    QString appDesc = jsonObjectToString(rootObject.value("appDesc").toObject());
+    QString appDesc = jsonObjectToString(applyLaunchOptions(rootObject.value("appDesc").toObject(), rootObject));
     QString params = "";
 
     if (rootObject.contains("params")) {
@@ -162,14 +222,15 @@ bool WebAppManagerService::launchApp(LSMessage &message)
 
     int processId = rootObject.value("processId").toInt();
 
-    WebApplication *app = mWebAppManager->launchApp(appDesc, params, processId);
+    QString errorText = "Failed to launch application";
+    WebApplication *app = mWebAppManager->launchApp(appDesc, params, processId, &errorText);
 
     QJsonObject response;
 
     response.insert("returnValue", QJsonValue(app != 0));
 
     if (!app)
-        response.insert("errorText", QJsonValue(QString("Failed to launch application")));
+        response.insert("errorText", QJsonValue(errorText));
     else
         response.insert("processId", QJsonValue((qint64) app->processId()));
 
@@ -177,16 +238,16 @@ bool WebAppManagerService::launchApp(LSMessage &message)
 
     QJsonDocument responseDocument(response);
 
-    request.respond(responseDocument.toJson().constData());
+    request.respond(responseDocument.toJson());
 
     return true;
 }
 
-bool WebAppManagerService::launchUrl(LSMessage &message)
+bool WebAppManagerService::launchUrl(ServiceRequest &request)
 {
-    LS::Message request(&message);
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
 
-    QByteArray payload(request.getPayload());
+    QByteArray payload = request.payload();
     if (payload.isEmpty()) {
         request.respond("{\"returnValue\":false,\"errorText\":\"Bad JSON\"}");
         return true;
@@ -218,7 +279,7 @@ bool WebAppManagerService::launchUrl(LSMessage &message)
 
     QString appDesc = "";
     if (rootObject.contains("appDesc") && rootObject.value("appDesc").isObject())
-        appDesc = jsonObjectToString(rootObject.value("appDesc").toObject());
+        appDesc = jsonObjectToString(applyLaunchOptions(rootObject.value("appDesc").toObject(), rootObject));
 
     QString params = "";
     if (rootObject.contains("params") && rootObject.value("params").isObject())
@@ -226,14 +287,15 @@ bool WebAppManagerService::launchUrl(LSMessage &message)
 
     int processId = rootObject.value("processId").toInt();
 
-    WebApplication *app = mWebAppManager->launchUrl(url, windowType, appDesc, params, processId);
+    QString errorText = "Failed to launch application";
+    WebApplication *app = mWebAppManager->launchUrl(url, windowType, appDesc, params, processId, &errorText);
 
     QJsonObject response;
 
     response.insert("returnValue", QJsonValue(app != 0));
 
     if (!app)
-        response.insert("errorText", QJsonValue(QString("Failed to launch application")));
+        response.insert("errorText", QJsonValue(errorText));
     else
         response.insert("processId", QJsonValue((qint64) app->processId()));
 
@@ -241,16 +303,16 @@ bool WebAppManagerService::launchUrl(LSMessage &message)
 
     QJsonDocument responseDocument(response);
 
-    request.respond(responseDocument.toJson().constData());
+    request.respond(responseDocument.toJson());
 
     return true;
 }
 
-bool WebAppManagerService::killApp(LSMessage &message)
+bool WebAppManagerService::killApp(ServiceRequest &request)
 {
-    LS::Message request(&message);
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
 
-    QJsonDocument document = QJsonDocument::fromJson(request.getPayload());
+    QJsonDocument document = QJsonDocument::fromJson(request.payload());
 
     QJsonObject root = document.object();
 
@@ -272,9 +334,77 @@ bool WebAppManagerService::killApp(LSMessage &message)
     return true;
 }
 
-bool WebAppManagerService::listRunningApps(LSMessage &message)
+/*!
+\page org_webosports_webappmanager
+\n
+\section org_webosports_webappmanager_close_apps closeApps
+
+\e Private
+
+org.webosports.webappmanager/closeApps
+
+Close several applications at once. Their windows are hidden and subscribers
+of registerForAppEvents are told about them being finished right away, the
+applications are then taken apart step by step in the background.
+
+\subsection org_webosports_webappmanager_close_apps_syntax Syntax:
+\code
+{
+    "appIds": [ string ]
+}
+\endcode
+
+\param appIds Ids of the applications to close.
+
+\subsection org_webosports_webappmanager_close_apps_returns Returns:
+\code
+{
+    "returnValue": boolean,
+    "errorText": string,
+    "closed": [ string ]
+}
+\endcode
+
+\param returnValue Indicates if the call was successful.
+\param errorText Describes the error if call was not successful.
+\param closed Ids of the applications which were running and are closed now.
+
+\subsection org_webosports_webappmanager_close_apps_examples Examples:
+\code
+luna-send -n 1 palm://org.webosports.webappmanager/closeApps '{"appIds":["org.webosports.app.memos","org.webosports.app.calculator"]}'
+\endcode
+*/
+bool WebAppManagerService::closeApps(ServiceRequest &request)
+{
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
+
+    QJsonObject root = QJsonDocument::fromJson(request.payload()).object();
+
+    if (!root.value("appIds").isArray()) {
+        request.respond("{\"returnValue\":false,\"errorText\":\"Missing appIds parameter\"}");
+        return true;
+    }
+
+    QStringList appIds;
+    Q_FOREACH(const QJsonValue &value, root.value("appIds").toArray()) {
+        if (value.isString())
+            appIds.append(value.toString());
+    }
+
+    QStringList closed = mWebAppManager->closeApps(appIds);
+
+    QJsonObject response;
+    response.insert("returnValue", true);
+    response.insert("closed", QJsonArray::fromStringList(closed));
+
+    request.respond(QJsonDocument(response).toJson());
+
+    return true;
+}
+
+bool WebAppManagerService::listRunningApps(ServiceRequest &request)
 {
-    LS::Message request(&message);
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
 
     QJsonObject rootObj;
 
@@ -290,16 +420,16 @@ bool WebAppManagerService::listRunningApps(LSMessage &message)
 
     QJsonDocument document(rootObj);
 
-    request.respond(document.toJson().constData());
+    request.respond(document.toJson());
 
     return true;
 }
 
-bool WebAppManagerService::isAppRunning(LSMessage &message)
+bool WebAppManagerService::isAppRunning(ServiceRequest &request)
 {
-    LS::Message request(&message);
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
 
-    QJsonDocument document = QJsonDocument::fromJson(QByteArray(request.getPayload()));
+    QJsonDocument document = QJsonDocument::fromJson(request.payload());
 
     QJsonObject root = document.object();
 
@@ -313,21 +443,21 @@ bool WebAppManagerService::isAppRunning(LSMessage &message)
     bool running = mWebAppManager->isAppRunning(appId);
     QString response = QString("{\"returnValue\":true,\"running\":%1}").arg(running ? "true" : "false");
 
-    request.respond(response.toUtf8().constData());
+    request.respond(response.toUtf8());
 
     return true;
 }
 
-bool WebAppManagerService::registerForAppEvents(LSMessage &message)
+bool WebAppManagerService::registerForAppEvents(ServiceRequest &request)
 {
-    LS::Message request(&message);
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
 
     if (!request.isSubscription()) {
         request.respond("{\"returnValue\":false,\"errorText\":\"You can only subscribe to this method\"}");
         return true;
     }
 
-    mAppEventSubscriptions.subscribe(request);
+    mTransport->subscribe("appEvents", request);
 
     request.respond("{\"returnValue\":true}");
 
@@ -340,7 +470,16 @@ void WebAppManagerService::notifyAppHasStarted(const QString &appId, int64_t pro
                         .arg(appId)
                         .arg(processId);
 
-    mAppEventSubscriptions.post(payload.toUtf8().constData());
+    mTransport->post("appEvents", payload.toUtf8());
+}
+
+void WebAppManagerService::notifyAppLaunchFailed(const QString &appId, int64_t processId)
+{
+    QString payload = QString("{\"event\":\"launchFailed\",\"appId\":\"%1\",\"processId\":%2}")
+                        .arg(appId)
+                        .arg(processId);
+
+    mTransport->post("appEvents", payload.toUtf8());
 }
 
 void WebAppManagerService::notifyAppHasFinished(const QString &appId, int64_t processId)
@@ -349,14 +488,14 @@ void WebAppManagerService::notifyAppHasFinished(const QString &appId, int64_t pr
                         .arg(appId)
                         .arg(processId);
 
-    mAppEventSubscriptions.post(payload.toUtf8().constData());
+    mTransport->post("appEvents", payload.toUtf8());
 }
 
-bool WebAppManagerService::relaunch(LSMessage &message)
+bool WebAppManagerService::relaunch(ServiceRequest &request)
 {
-    LS::Message request(&message);
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
 
-    QJsonDocument document = QJsonDocument::fromJson(QByteArray(request.getPayload()));
+    QJsonDocument document = QJsonDocument::fromJson(request.payload());
 
     QJsonObject root = document.object();
 
@@ -371,20 +510,25 @@ bool WebAppManagerService::relaunch(LSMessage &message)
     if (root.contains("params") && root.value("params").isString())
         params = root.value("params").toString();
 
-    bool success = mWebAppManager->relaunch(appId, params);
-    if (!success)
-        request.respond("{\"returnValue\":false,\"errorText\":\"Failed to relaunch application\"}");
+    QString errorText = "Failed to relaunch application";
+    bool success = mWebAppManager->relaunch(appId, params, &errorText);
+    if (!success) {
+        QJsonObject response;
+        response.insert("returnValue", false);
+        response.insert("errorText", errorText);
+        request.respond(QJsonDocument(response).toJson());
+    }
     else
         request.respond("{\"returnValue\":true}");
 
     return true;
 }
 
-bool WebAppManagerService::clearMemoryCaches(LSMessage &message)
+bool WebAppManagerService::clearMemoryCaches(ServiceRequest &request)
 {
-    LS::Message request(&message);
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
 
-    QJsonDocument document = QJsonDocument::fromJson(QByteArray(request.getPayload()));
+    QJsonDocument document = QJsonDocument::fromJson(request.payload());
 
     QJsonObject root = document.object();
 
@@ -408,4 +552,232 @@ bool WebAppManagerService::clearMemoryCaches(LSMessage &message)
     return true;
 }
 
+/*!
+\page org_webosports_webappmanager
+\n
+\section org_webosports_webappmanager_set_log_level setLogLevel
+
+\e Private
+
+org.webosports.webappmanager/setLogLevel
+
+Change the log level of one or all logging categories at runtime.
+
+\subsection org_webosports_webappmanager_set_log_level_syntax Syntax:
+\code
+{
+    "category": string,
+    "level": string,
+    "appId": string
+}
+\endcode
+
+\param category One of launch, window, bridge, extensions, service, activity, memory, frames, watchdog or * for all of them
+\param level One of debug, warning, critical or none
+\param appId Optional. Restrict per application output (bridge tracing) to the given application
+
+\subsection org_webosports_webappmanager_set_log_level_returns Returns:
+\code
+{
+    "returnValue": boolean,
+    "errorText": string
+}
+\endcode
+
+\param returnValue Indicates if the call was successful.
+\param errorText Describes the error if call was not successful.
+
+\subsection org_webosports_webappmanager_set_log_level_examples Examples:
+\code
+luna-send -n 1 palm://org.webosports.webappmanager/setLogLevel '{"category":"bridge","level":"debug","appId":"org.webosports.app.memos"}'
+\endcode
+*/
+bool WebAppManagerService::setLogLevel(ServiceRequest &request)
+{
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
+
+    QJsonDocument document = QJsonDocument::fromJson(request.payload());
+
+    QJsonObject root = document.object();
+
+    if (!root.value("category").isString() || !root.value("level").isString()) {
+        request.respond("{\"returnValue\":false,\"errorText\":\"Missing category or level parameter\"}");
+        return true;
+    }
+
+    QString category = root.value("category").toString();
+    QString level = root.value("level").toString();
+    QString appId = root.value("appId").toString();
+
+    if (!luna::setLogLevel(category, level, appId)) {
+        request.respond("{\"returnValue\":false,\"errorText\":\"Invalid category or level\"}");
+        return true;
+    }
+
+    request.respond("{\"returnValue\":true}");
+
+    return true;
+}
+
+/*!
+\page org_webosports_webappmanager
+\n
+\section org_webosports_webappmanager_get_frame_statistics getFrameStatistics
+
+\e Private
+
+org.webosports.webappmanager/getFrameStatistics
+
+Get the frame timing statistics of all windows. Frames taking longer than
+the budget are attributed to the work the manager did while they were
+produced; one frame can count for several kinds of work.
+
+\subsection org_webosports_webappmanager_get_frame_statistics_syntax Syntax:
+\code
+{
+    "appId": string,
+    "reset": boolean
+}
+\endcode
+
+\param appId Optional. Only report the windows of the given application
+\param reset Optional. Start counting from zero again after reporting
+
+\subsection org_webosports_webappmanager_get_frame_statistics_returns Returns:
+\code
+{
+    "returnValue": boolean,
+    "apps": [
+        {
+            "appId": string,
+            "processId": number,
+            "windows": [
+                {
+                    "windowType": string,
+                    "windowId": number,
+                    "frames": number,
+                    "overBudget": number,
+                    "budget": number,
+                    "longest": number,
+                    "histogram": [ { "below": number, "frames": number } ],
+                    "longFrames": {
+                        "script": number,
+                        "launch": number,
+                        "service": number,
+                        "unattributed": number
+                    }
+                }
+            ]
+        }
+    ]
+}
+\endcode
+
+\param returnValue Indicates if the call was successful.
+\param apps The applications with their windows. All times are in milliseconds,
+the last histogram bucket has no upper limit.
+
+\subsection org_webosports_webappmanager_get_frame_statistics_examples Examples:
+\code
+luna-send -n 1 palm://org.webosports.webappmanager/getFrameStatistics '{"appId":"org.webosports.app.memos"}'
+\endcode
+*/
+bool WebAppManagerService::getFrameStatistics(ServiceRequest &request)
+{
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
+
+    QJsonObject root = QJsonDocument::fromJson(request.payload()).object();
+    QString appId = root.value("appId").toString();
+    bool reset = root.value("reset").toBool(false);
+
+    QJsonArray apps;
+    Q_FOREACH(WebApplication *app, mWebAppManager->applications()) {
+        if (!appId.isEmpty() && app->id() != appId)
+            continue;
+
+        QJsonArray windows;
+        Q_FOREACH(WebApplicationWindow *window, app->windows()) {
+            FrameStatistics *statistics = window->frameStatistics();
+            if (!statistics)
+                continue;
+
+            QJsonObject windowObj = statistics->toJson();
+            windowObj.insert("windowType", window->windowType());
+            windowObj.insert("windowId", window->windowId());
+            windows.append(windowObj);
+
+            if (reset)
+                statistics->reset();
+        }
+
+        QJsonObject appObj;
+        appObj.insert("appId", app->id());
+        appObj.insert("processId", (qint64) app->processId());
+        appObj.insert("windows", windows);
+        apps.append(appObj);
+    }
+
+    QJsonObject response;
+    response.insert("returnValue", true);
+    response.insert("apps", apps);
+
+    request.respond(QJsonDocument(response).toJson());
+
+    return true;
+}
+
+/*!
+\page org_webosports_webappmanager
+\n
+\section org_webosports_webappmanager_get_stall_statistics getStallStatistics
+
+\e Private
+
+org.webosports.webappmanager/getStallStatistics
+
+Get the stalls of the event loop recorded by the watchdog. A stall is
+attributed to the service call, launch stage or bridge call being handled
+at the time, otherwise to the event being delivered.
+
+\subsection org_webosports_webappmanager_get_stall_statistics_syntax Syntax:
+\code
+{
+}
+\endcode
+
+\subsection org_webosports_webappmanager_get_stall_statistics_returns Returns:
+\code
+{
+    "returnValue": boolean,
+    "threshold": number,
+    "stalls": number,
+    "sources": [ { "source": string, "count": number, "totalTime": number, "longest": number } ],
+    "recent": [ { "time": number, "duration": number, "source": string, "backtrace": [ string ] } ]
+}
+\endcode
+
+\param returnValue Indicates if the call was successful.
+\param threshold Time in milliseconds the event loop has to be blocked to count as stall,
+0 when only the systemd watchdog is fed.
+\param stalls Number of stalls since the start.
+\param sources Stalls counted per source.
+\param recent The last stalls with a backtrace of the GUI thread taken while it was blocked.
+
+\subsection org_webosports_webappmanager_get_stall_statistics_examples Examples:
+\code
+luna-send -n 1 palm://org.webosports.webappmanager/getStallStatistics '{}'
+\endcode
+*/
+bool WebAppManagerService::getStallStatistics(ServiceRequest &request)
+{
+    qCDebug(lcService) << Q_FUNC_INFO << request.payload();
+
+    QJsonObject response = Watchdog::instance()->statistics();
+    response.insert("returnValue", true);
+
+    request.respond(QJsonDocument(response).toJson());
+
+    return true;
+}
+
 } // namespace luna
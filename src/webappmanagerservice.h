@@ -18,36 +18,51 @@
 #ifndef WEBAPPMANAGERSERVICE_H_
 #define WEBAPPMANAGERSERVICE_H_
 
-#include <glib.h>
-#include <luna-service2/lunaservice.hpp>
+#include <QString>
+#include <stdint.h>
+
+#include "servicetransport.h"
+#include "servicerecorder.h"
 
 namespace luna
 {
 
 class WebAppManager;
 
-class WebAppManagerService : private LS::Handle
+class WebAppManagerService
 {
 public:
-    WebAppManagerService(WebAppManager *webAppManager);
+    WebAppManagerService(WebAppManager *webAppManager, ServiceTransport *transport);
     ~WebAppManagerService();
 
     void notifyAppHasStarted(const QString& appId, int64_t processId);
     void notifyAppHasFinished(const QString& appId, int64_t processId);
+    void notifyAppLaunchFailed(const QString& appId, int64_t processId);
+
+    bool startRecording(const QString &path);
+    void stopRecording();
 
 private:
-    bool launchApp(LSMessage &message);
-    bool launchUrl(LSMessage &message);
-    bool killApp(LSMessage &message);
-    bool isAppRunning(LSMessage &message);
-    bool listRunningApps(LSMessage &message);
-    bool registerForAppEvents(LSMessage &message);
-    bool relaunch(LSMessage &message);
-    bool clearMemoryCaches(LSMessage &message);
+    bool dispatch(const char *method, ServiceRequest &request,
+                  bool (WebAppManagerService::*handler)(ServiceRequest&));
+
+    bool launchApp(ServiceRequest &request);
+    bool launchUrl(ServiceRequest &request);
+    bool killApp(ServiceRequest &request);
+    bool closeApps(ServiceRequest &request);
+    bool isAppRunning(ServiceRequest &request);
+    bool listRunningApps(ServiceRequest &request);
+    bool registerForAppEvents(ServiceRequest &request);
+    bool relaunch(ServiceRequest &request);
+    bool clearMemoryCaches(ServiceRequest &request);
+    bool setLogLevel(ServiceRequest &request);
+    bool getFrameStatistics(ServiceRequest &request);
+    bool getStallStatistics(ServiceRequest &request);
 
 private:
     WebAppManager *mWebAppManager;
-    LS::SubscriptionPoint mAppEventSubscriptions;
+    ServiceTransport *mTransport;
+    ServiceRecorder mRecorder;
 };
 
 } // namespace luna
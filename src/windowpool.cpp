@@ -0,0 +1,158 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDebug>
+#include <QJSValueIterator>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQuickItem>
+#include <QQuickView>
+
+#include "windowpool.h"
+#include "logging.h"
+
+#define WINDOW_POOL_SIZE    3
+
+namespace luna
+{
+
+WindowPool* WindowPool::instance()
+{
+    static WindowPool* instance = 0;
+
+    if (!instance)
+        instance = new WindowPool();
+
+    return instance;
+}
+
+WindowPool::WindowPool() :
+    mCount(0)
+{
+}
+
+QQuickView* WindowPool::acquire(const QString &windowType)
+{
+    while (!mViews.value(windowType).isEmpty()) {
+        QQuickView *view = mViews[windowType].takeLast();
+        mCount--;
+
+        // Whatever the previous application left behind must not be seen by
+        // the next one, so rather start from scratch than take any chance
+        if (!isClean(view)) {
+            qWarning() << "BUG: Dropping pooled" << windowType << "window with state left behind";
+            drop(view);
+            continue;
+        }
+
+        qCDebug(lcWindow) << "Reusing pooled" << windowType << "window";
+        return view;
+    }
+
+    // What a fresh engine looks like, so we can tell when an application
+    // changed it for everyone after it
+    QQuickView *view = new QQuickView;
+    mEngineStates.insert(view, engineState(view->engine()));
+
+    return view;
+}
+
+void WindowPool::release(const QString &windowType, QQuickView *view)
+{
+    if (mCount >= WINDOW_POOL_SIZE) {
+        drop(view);
+        return;
+    }
+
+    // Dropping the content takes the web view and with it the web process
+    // down, so no page state survives
+    view->hide();
+    view->setSource(QUrl());
+    view->destroy();
+
+    view->setPersistentOpenGLContext(true);
+    view->setPersistentSceneGraph(true);
+
+    view->engine()->collectGarbage();
+
+    if (!isClean(view)) {
+        drop(view);
+        return;
+    }
+
+    if (engineState(view->engine()) != mEngineStates.value(view)) {
+        qCDebug(lcWindow) << "Not pooling" << windowType << "window as its engine was changed";
+        drop(view);
+        return;
+    }
+
+    mViews[windowType].append(view);
+    mCount++;
+
+    qCDebug(lcWindow) << "Pooled" << windowType << "window," << mCount << "windows pooled";
+}
+
+bool WindowPool::isClean(QQuickView *view) const
+{
+    QQmlContext *context = view->rootContext();
+
+    return !view->rootObject() && !view->handle() &&
+           !context->contextProperty("webApp").value<QObject*>() &&
+           !context->contextProperty("webAppWindow").value<QObject*>() &&
+           view->contentItem()->childItems().isEmpty();
+}
+
+void WindowPool::drop(QQuickView *view)
+{
+    mEngineStates.remove(view);
+    delete view;
+}
+
+QStringList WindowPool::engineState(QQmlEngine *engine)
+{
+    QStringList state;
+
+    QJSValueIterator it(engine->globalObject());
+    while (it.hasNext()) {
+        it.next();
+        state << QString("global:%1").arg(it.name());
+    }
+
+    Q_FOREACH(const QByteArray &name, engine->dynamicPropertyNames())
+        state << QString("property:%1").arg(QString(name));
+
+    Q_FOREACH(const QString &path, engine->importPathList())
+        state << QString("import:%1").arg(path);
+
+    if (engine->rootContext()->contextObject())
+        state << QString("contextObject");
+
+    return state;
+}
+
+void WindowPool::clear()
+{
+    Q_FOREACH(const QList<QQuickView*> &views, mViews) {
+        Q_FOREACH(QQuickView *view, views)
+            drop(view);
+    }
+
+    mViews.clear();
+    mCount = 0;
+}
+
+} // namespace luna
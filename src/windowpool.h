@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WINDOWPOOL_H
+#define WINDOWPOOL_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+class QQmlEngine;
+class QQuickView;
+
+namespace luna
+{
+
+/*
+ * Bounded pool of views left behind by closed windows. A view is scrubbed
+ * before it's put back: its content and platform window are destroyed, so
+ * only the view and its QML engine with the already compiled container
+ * survive. Windows keep their own state in a context of their own; a view
+ * whose engine was changed beyond that (global object, engine properties,
+ * import paths) since it was created isn't pooled again. Views are only
+ * handed out again for windows of the same type.
+ */
+class WindowPool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static WindowPool* instance();
+
+    QQuickView* acquire(const QString &windowType);
+    void release(const QString &windowType, QQuickView *view);
+
+    void clear();
+
+private:
+    WindowPool();
+
+    QMap<QString, QList<QQuickView*> > mViews;
+    QMap<QQuickView*, QStringList> mEngineStates;
+    int mCount;
+
+    bool isClean(QQuickView *view) const;
+    void drop(QQuickView *view);
+
+    static QStringList engineState(QQmlEngine *engine);
+};
+
+} // namespace luna
+
+#endif // WINDOWPOOL_H
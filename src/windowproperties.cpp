@@ -0,0 +1,142 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDebug>
+#include <QGuiApplication>
+#include <QWindow>
+
+#include <QtGui/qpa/qplatformnativeinterface.h>
+
+#include "windowproperties.h"
+#include "logging.h"
+
+namespace luna
+{
+
+WindowProperties::WindowProperties(QWindow *window) :
+    mWindow(window),
+    mSentCount(0),
+    mSkippedCount(0)
+{
+}
+
+void WindowProperties::setWindow(QWindow *window)
+{
+    if (window == mWindow)
+        return;
+
+    // A different window means a different surface on the compositor side
+    // which doesn't know anything we told the previous one
+    mWindow = window;
+    mSent.clear();
+}
+
+void WindowProperties::setProperty(const QString &name, const QVariant &value)
+{
+    if (!mWindow || !mWindow->handle()) {
+        for (int n = 0; n < mPending.count(); n++) {
+            if (mPending[n].first == name) {
+                mPending[n].second = value;
+                return;
+            }
+        }
+
+        mPending.append(qMakePair(name, value));
+        return;
+    }
+
+    send(name, value);
+}
+
+QVariant WindowProperties::property(const QString &name) const
+{
+    if (!mWindow || !mWindow->handle()) {
+        for (int n = 0; n < mPending.count(); n++) {
+            if (mPending[n].first == name)
+                return mPending[n].second;
+        }
+
+        return QVariant();
+    }
+
+    QPlatformNativeInterface *nativeInterface = QGuiApplication::platformNativeInterface();
+    if (!nativeInterface)
+        return mSent.value(name);
+
+    return nativeInterface->windowProperty(mWindow->handle(), name);
+}
+
+int WindowProperties::flush()
+{
+    if (!mWindow || !mWindow->handle()) {
+        qWarning() << "Can't flush window properties before the platform window is created";
+        return 0;
+    }
+
+    int sent = 0;
+
+    // Keep the order the properties were set in as the compositor might
+    // act on one (like the window type) before it looks at the others
+    for (int n = 0; n < mPending.count(); n++) {
+        if (send(mPending[n].first, mPending[n].second))
+            sent++;
+    }
+
+    mPending.clear();
+
+    qCDebug(lcWindow) << "Flushed" << sent << "staged window properties";
+
+    return sent;
+}
+
+void WindowProperties::invalidate(const QString &name)
+{
+    // The compositor changed the property on its own so what we sent last
+    // isn't what it has anymore
+    mSent.remove(name);
+}
+
+int WindowProperties::sentCount() const
+{
+    return mSentCount;
+}
+
+int WindowProperties::skippedCount() const
+{
+    return mSkippedCount;
+}
+
+bool WindowProperties::send(const QString &name, const QVariant &value)
+{
+    QVariantMap::const_iterator iter = mSent.constFind(name);
+    if (iter != mSent.constEnd() && iter.value() == value) {
+        mSkippedCount++;
+        return false;
+    }
+
+    QPlatformNativeInterface *nativeInterface = QGuiApplication::platformNativeInterface();
+    if (!nativeInterface)
+        return false;
+
+    nativeInterface->setWindowProperty(mWindow->handle(), name, value);
+    mSent.insert(name, value);
+    mSentCount++;
+
+    return true;
+}
+
+} // namespace luna
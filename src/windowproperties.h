@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WINDOWPROPERTIES_H
+#define WINDOWPROPERTIES_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+
+class QWindow;
+
+namespace luna
+{
+
+/*
+ * Window properties the compositor gets told about through the platform
+ * native interface. Properties set before the platform window exists are
+ * staged and go out together with flush(), right after the window was
+ * created and before its first frame is committed. Values the compositor
+ * already knows about are not sent again.
+ */
+class WindowProperties
+{
+public:
+    explicit WindowProperties(QWindow *window = 0);
+
+    void setWindow(QWindow *window);
+
+    void setProperty(const QString &name, const QVariant &value);
+    QVariant property(const QString &name) const;
+
+    int flush();
+    void invalidate(const QString &name);
+
+    int sentCount() const;
+    int skippedCount() const;
+
+private:
+    QWindow *mWindow;
+    QList<QPair<QString, QVariant> > mPending;
+    QVariantMap mSent;
+    int mSentCount;
+    int mSkippedCount;
+
+    bool send(const QString &name, const QVariant &value);
+};
+
+} // namespace luna
+
+#endif // WINDOWPROPERTIES_H
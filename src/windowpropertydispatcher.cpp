@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QDebug>
+#include <QGuiApplication>
+#include <QtGui/qpa/qplatformnativeinterface.h>
+
+#include "windowpropertydispatcher.h"
+#include "webapplicationwindow.h"
+#include "logging.h"
+
+namespace luna
+{
+
+WindowPropertyDispatcher* WindowPropertyDispatcher::instance()
+{
+    static WindowPropertyDispatcher* instance = 0;
+
+    if (!instance)
+        instance = new WindowPropertyDispatcher();
+
+    return instance;
+}
+
+WindowPropertyDispatcher::WindowPropertyDispatcher()
+{
+    QPlatformNativeInterface *nativeInterface = QGuiApplication::platformNativeInterface();
+    if (nativeInterface)
+        connect(nativeInterface, SIGNAL(windowPropertyChanged(QPlatformWindow*, const QString&)),
+                this, SLOT(onWindowPropertyChanged(QPlatformWindow*, const QString&)));
+}
+
+void WindowPropertyDispatcher::add(QPlatformWindow *platformWindow, WebApplicationWindow *window)
+{
+    if (!platformWindow)
+        return;
+
+    mWindows.insert(platformWindow, window);
+}
+
+void WindowPropertyDispatcher::remove(QPlatformWindow *platformWindow)
+{
+    if (!platformWindow)
+        return;
+
+    mWindows.remove(platformWindow);
+}
+
+void WindowPropertyDispatcher::onWindowPropertyChanged(QPlatformWindow *platformWindow, const QString &name)
+{
+    WebApplicationWindow *window = mWindows.value(platformWindow);
+    if (!window) {
+        qCDebug(lcWindow) << "Ignoring change of property" << name << "for unknown window";
+        return;
+    }
+
+    window->updateWindowProperty(name);
+}
+
+} // namespace luna
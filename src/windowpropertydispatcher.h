@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WINDOWPROPERTYDISPATCHER_H
+#define WINDOWPROPERTYDISPATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+
+class QPlatformWindow;
+
+namespace luna
+{
+
+class WebApplicationWindow;
+
+/*
+ * Single listener for the property changes the compositor reports through
+ * the platform native interface. Changes are only delivered to the window
+ * owning the platform window instead of every window checking for itself.
+ */
+class WindowPropertyDispatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    static WindowPropertyDispatcher* instance();
+
+    void add(QPlatformWindow *platformWindow, WebApplicationWindow *window);
+    void remove(QPlatformWindow *platformWindow);
+
+private Q_SLOTS:
+    void onWindowPropertyChanged(QPlatformWindow *platformWindow, const QString &name);
+
+private:
+    WindowPropertyDispatcher();
+
+    QHash<QPlatformWindow*, WebApplicationWindow*> mWindows;
+};
+
+} // namespace luna
+
+#endif // WINDOWPROPERTYDISPATCHER_H
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QtTest>
+
+#include "launchscheduler.h"
+
+using namespace luna;
+
+class LaunchSchedulerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void backgroundWaitsForForeground();
+    void finishedLaunchWithoutLoad();
+    void launchNeverLoads();
+    void relaunchDoesNotWaitForLoads();
+    void backgroundJobDoesNotWaitForDeferredLoad();
+};
+
+void LaunchSchedulerTest::backgroundWaitsForForeground()
+{
+    LaunchScheduler scheduler;
+    bool foregroundStarted = false;
+    bool backgroundStarted = false;
+
+    QVERIFY(scheduler.schedule("org.webosports.app.foreground", LaunchScheduler::PriorityForeground,
+                               [&foregroundStarted]() { foregroundStarted = true; }, true));
+    QVERIFY(scheduler.schedule("org.webosports.app.background", LaunchScheduler::PriorityBackground,
+                               [&backgroundStarted]() { backgroundStarted = true; }, true));
+
+    QTRY_VERIFY(foregroundStarted);
+    QTest::qWait(100);
+    QVERIFY(!backgroundStarted);
+    QCOMPARE(scheduler.queued(), 1);
+}
+
+void LaunchSchedulerTest::finishedLaunchWithoutLoad()
+{
+    LaunchScheduler scheduler;
+    bool backgroundStarted = false;
+
+    // What the manager does for a deferred window once its launch stages
+    // are done: it never loads, so the slot is released right away
+    QVERIFY(scheduler.schedule("org.webosports.app.deferred", LaunchScheduler::PriorityForeground,
+                               [&scheduler]() { scheduler.finished("org.webosports.app.deferred"); }, true));
+    QVERIFY(scheduler.schedule("org.webosports.app.background", LaunchScheduler::PriorityBackground,
+                               [&backgroundStarted]() { backgroundStarted = true; }, true));
+
+    QTRY_VERIFY(backgroundStarted);
+    QCOMPARE(scheduler.inProgress(), 1);
+}
+
+void LaunchSchedulerTest::launchNeverLoads()
+{
+    LaunchScheduler scheduler;
+    bool backgroundStarted = false;
+
+    QVERIFY(scheduler.schedule("org.webosports.app.stuck", LaunchScheduler::PriorityForeground,
+                               []() { }, true));
+    QVERIFY(scheduler.schedule("org.webosports.app.background", LaunchScheduler::PriorityBackground,
+                               [&backgroundStarted]() { backgroundStarted = true; }, true));
+
+    // The load timeout eventually gives up on the stuck launch
+    QTRY_VERIFY_WITH_TIMEOUT(backgroundStarted, 15000);
+    QCOMPARE(scheduler.queued(), 0);
+}
+
+void LaunchSchedulerTest::relaunchDoesNotWaitForLoads()
+{
+    LaunchScheduler scheduler;
+    bool blockedStarted = false;
+    bool relaunched = false;
+
+    // Both load slots are taken by pages which don't finish loading
+    QVERIFY(scheduler.schedule("org.webosports.app.loading1", LaunchScheduler::PriorityForeground,
+                               []() { }, true));
+    QVERIFY(scheduler.schedule("org.webosports.app.loading2", LaunchScheduler::PriorityForeground,
+                               []() { }, true));
+    QVERIFY(scheduler.schedule("org.webosports.app.blocked", LaunchScheduler::PriorityForeground,
+                               [&blockedStarted]() { blockedStarted = true; }, true));
+    QVERIFY(scheduler.schedule("org.webosports.app.running", LaunchScheduler::PriorityRelaunch,
+                               [&relaunched]() { relaunched = true; }, false));
+
+    QTRY_VERIFY_WITH_TIMEOUT(relaunched, 1000);
+    QVERIFY(!blockedStarted);
+    QCOMPARE(scheduler.inProgress(), 2);
+    QCOMPARE(scheduler.queued(), 1);
+}
+
+void LaunchSchedulerTest::backgroundJobDoesNotWaitForDeferredLoad()
+{
+    LaunchScheduler scheduler;
+    bool deferredStarted = false;
+    bool backgroundRan = false;
+
+    QVERIFY(scheduler.schedule("org.webosports.app.foreground", LaunchScheduler::PriorityForeground,
+                               []() { }, true));
+    QVERIFY(scheduler.schedule("org.webosports.app.background", LaunchScheduler::PriorityBackground,
+                               [&deferredStarted]() { deferredStarted = true; }, true));
+    QVERIFY(scheduler.schedule("org.webosports.app.other", LaunchScheduler::PriorityBackground,
+                               [&backgroundRan]() { backgroundRan = true; }, false));
+
+    QTRY_VERIFY_WITH_TIMEOUT(backgroundRan, 1000);
+    QVERIFY(!deferredStarted);
+    QCOMPARE(scheduler.queued(), 1);
+}
+
+QTEST_GUILESS_MAIN(LaunchSchedulerTest)
+
+#include "tst_launchscheduler.moc"
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QtTest>
+
+#include "logging.h"
+
+using namespace luna;
+
+class LoggingTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+
+    void traceSingleApp();
+    void lowerGlobalLevelAfterTracing();
+    void lowerCategoryLevelAfterTracing();
+    void rejectUnknown();
+};
+
+void LoggingTest::init()
+{
+    initializeLogging(false);
+    setLogLevel("*", "warning");
+}
+
+void LoggingTest::traceSingleApp()
+{
+    QVERIFY(setLogLevel("launch", "debug", "org.webosports.app.traced"));
+
+    QVERIFY(lcLaunch().isDebugEnabled());
+    QVERIFY(isLoggingEnabledForApp("org.webosports.app.traced"));
+    QVERIFY(!isLoggingEnabledForApp("org.webosports.app.other"));
+}
+
+void LoggingTest::lowerGlobalLevelAfterTracing()
+{
+    QVERIFY(setLogLevel("launch", "debug", "org.webosports.app.traced"));
+    QVERIFY(setLogLevel("*", "warning"));
+
+    QVERIFY(!lcLaunch().isDebugEnabled());
+
+    // Enabling debug output for everyone later on must not be limited to
+    // the application traced before
+    QVERIFY(setLogLevel("*", "debug"));
+    QVERIFY(isLoggingEnabledForApp("org.webosports.app.other"));
+}
+
+void LoggingTest::lowerCategoryLevelAfterTracing()
+{
+    QVERIFY(setLogLevel("window", "debug", "org.webosports.app.traced"));
+    QVERIFY(setLogLevel("window", "critical"));
+
+    QVERIFY(!lcWindow().isDebugEnabled());
+    QVERIFY(!lcWindow().isWarningEnabled());
+    QVERIFY(isLoggingEnabledForApp("org.webosports.app.other"));
+}
+
+void LoggingTest::rejectUnknown()
+{
+    QVERIFY(!setLogLevel("doesNotExist", "debug"));
+    QVERIFY(!setLogLevel("launch", "verbose"));
+}
+
+QTEST_GUILESS_MAIN(LoggingTest)
+
+#include "tst_logging.moc"
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <stdlib.h>
+
+#include "localservicetransport.h"
+#include "tombstone.h"
+#include "utils.h"
+#include "webapplication.h"
+#include "webappmanager.h"
+
+using namespace luna;
+
+static WebAppManager *sManager = 0;
+
+static QString createAppDescription(const QString &appId)
+{
+    QJsonObject desc;
+    desc.insert("id", appId);
+    desc.insert("title", QString("Tombstone"));
+    desc.insert("main", QString(FIXTURES_DIR "/preparing/index.html"));
+
+    return jsonObjectToString(desc);
+}
+
+static Tombstone* findTombstone(const QString &appId)
+{
+    Q_FOREACH(Tombstone *tombstone, sManager->findChildren<Tombstone*>()) {
+        if (tombstone->appId() == appId)
+            return tombstone;
+    }
+
+    return 0;
+}
+
+class TombstoneTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void swapOnFirstPaint();
+    void swapOnStageReadyTimeout();
+
+private:
+    void evictAndRestore(const QString &appId);
+};
+
+void TombstoneTest::evictAndRestore(const QString &appId)
+{
+    QString desc = createAppDescription(appId);
+
+    WebApplication *app = sManager->launchApp(desc, "{}", 1000);
+    QVERIFY(app);
+    QTRY_VERIFY(app->mainWindow() && !app->launching());
+
+    QVERIFY(sManager->tombstoneApp(appId));
+    QVERIFY(findTombstone(appId));
+
+    QVERIFY(sManager->launchApp(desc, "{}", 1001));
+    QVERIFY(findTombstone(appId)->restoring());
+}
+
+void TombstoneTest::swapOnFirstPaint()
+{
+    QString appId("org.webosports.test.tombstone.paint");
+
+    // The page never says it's ready but gets shown with its first content
+    sManager->setShowOnFirstPaint(true);
+
+    evictAndRestore(appId);
+
+    QTRY_VERIFY_WITH_TIMEOUT(!findTombstone(appId), 2000);
+    QVERIFY(sManager->isAppRunning(appId));
+
+    sManager->killApp(appId);
+    sManager->setShowOnFirstPaint(false);
+}
+
+void TombstoneTest::swapOnStageReadyTimeout()
+{
+    QString appId("org.webosports.test.tombstone.timeout");
+
+    evictAndRestore(appId);
+
+    // Neither ready nor painted early, the stage ready timeout shows it
+    QTRY_VERIFY_WITH_TIMEOUT(!findTombstone(appId), 5000);
+    QVERIFY(sManager->isAppRunning(appId));
+
+    sManager->killApp(appId);
+}
+
+int main(int argc, char **argv)
+{
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+
+    QTemporaryDir storage;
+    setenv("XDG_DATA_HOME", QString("%1/data").arg(storage.path()).toUtf8().constData(), 0);
+    setenv("XDG_CACHE_HOME", QString("%1/cache").arg(storage.path()).toUtf8().constData(), 0);
+
+    WebAppManager webAppManager(argc, argv, new LocalServiceTransport);
+    sManager = &webAppManager;
+
+    TombstoneTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_tombstone.moc"
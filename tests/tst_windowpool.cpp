@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2015 Simon Busch <morphis@gravedo.de>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include <QtTest>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPointer>
+#include <QQmlContext>
+#include <QQmlEngine>
+#include <QQmlExpression>
+#include <QQuickItem>
+#include <QTemporaryDir>
+
+#include <stdlib.h>
+
+#include "localservicetransport.h"
+#include "utils.h"
+#include "webapplication.h"
+#include "webapplicationwindow.h"
+#include "webappmanager.h"
+
+using namespace luna;
+
+static WebAppManager *sManager = 0;
+
+static QString createAppDescription(const QString &appId)
+{
+    QJsonObject desc;
+    desc.insert("id", appId);
+    desc.insert("title", QString("Window pool"));
+    desc.insert("main", QString(FIXTURES_DIR "/minimal/index.html"));
+
+    return jsonObjectToString(desc);
+}
+
+// Evaluates the script in the container of the window like the container
+// itself would
+static QString evaluate(WebApplicationWindow *window, const QString &script)
+{
+    QQmlExpression expression(QQmlEngine::contextForObject(window->rootItem()),
+                              window->rootItem(), script);
+    return expression.evaluate().toString();
+}
+
+class WindowPoolTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void reuseCleanView();
+    void containerStateDoesNotLeak();
+    void engineStateDoesNotLeak();
+
+private:
+    WebApplication* launch(const QString &appId);
+    void close(WebApplication *app);
+};
+
+WebApplication* WindowPoolTest::launch(const QString &appId)
+{
+    static int processId = 1000;
+
+    return sManager->launchApp(createAppDescription(appId), "{}", processId++);
+}
+
+void WindowPoolTest::close(WebApplication *app)
+{
+    QPointer<WebApplication> closed(app);
+    sManager->killApp(app->id());
+
+    // The window goes back to the pool during the teardown of the application
+    QTRY_VERIFY(!closed);
+}
+
+void WindowPoolTest::reuseCleanView()
+{
+    WebApplication *firstApp = launch("org.webosports.test.pool.clean.a");
+    QVERIFY(firstApp);
+    QTRY_VERIFY(firstApp->mainWindow() && !firstApp->launching());
+    WebApplicationWindow *first = firstApp->mainWindow();
+    QPointer<QQmlEngine> engine(first->qmlEngine());
+
+    close(firstApp);
+
+    WebApplication *secondApp = launch("org.webosports.test.pool.clean.b");
+    QVERIFY(secondApp);
+    QTRY_VERIFY(secondApp->mainWindow() && !secondApp->launching());
+    WebApplicationWindow *second = secondApp->mainWindow();
+    QVERIFY(engine);
+    QCOMPARE(second->qmlEngine(), engine.data());
+
+    close(secondApp);
+}
+
+void WindowPoolTest::containerStateDoesNotLeak()
+{
+    WebApplication *firstApp = launch("org.webosports.test.pool.context.a");
+    QVERIFY(firstApp);
+    QTRY_VERIFY(firstApp->mainWindow() && !firstApp->launching());
+    WebApplicationWindow *first = firstApp->mainWindow();
+    QPointer<QQmlEngine> engine(first->qmlEngine());
+
+    QQmlEngine::contextForObject(first->rootItem())->setContextProperty("leakedContext", 42);
+    QCOMPARE(evaluate(first, "typeof leakedContext"), QString("number"));
+    QCOMPARE(evaluate(first, "webApp.id"), QString("org.webosports.test.pool.context.a"));
+
+    close(firstApp);
+
+    WebApplication *secondApp = launch("org.webosports.test.pool.context.b");
+    QVERIFY(secondApp);
+    QTRY_VERIFY(secondApp->mainWindow() && !secondApp->launching());
+    WebApplicationWindow *second = secondApp->mainWindow();
+
+    // State of the window went away with it, so the view is still reused
+    QCOMPARE(second->qmlEngine(), engine.data());
+    QCOMPARE(evaluate(second, "typeof leakedContext"), QString("undefined"));
+    QCOMPARE(evaluate(second, "webApp.id"), QString("org.webosports.test.pool.context.b"));
+
+    close(secondApp);
+}
+
+void WindowPoolTest::engineStateDoesNotLeak()
+{
+    WebApplication *firstApp = launch("org.webosports.test.pool.engine.a");
+    QVERIFY(firstApp);
+    QTRY_VERIFY(firstApp->mainWindow() && !firstApp->launching());
+    WebApplicationWindow *first = firstApp->mainWindow();
+    QPointer<QQmlEngine> engine(first->qmlEngine());
+
+    first->qmlEngine()->setProperty("leakedProperty", 42);
+    first->qmlEngine()->globalObject().setProperty("leakedGlobal", 42);
+
+    close(firstApp);
+
+    WebApplication *secondApp = launch("org.webosports.test.pool.engine.b");
+    QVERIFY(secondApp);
+    QTRY_VERIFY(secondApp->mainWindow() && !secondApp->launching());
+    WebApplicationWindow *second = secondApp->mainWindow();
+
+    // A changed engine isn't handed out again
+    QVERIFY(second->qmlEngine() != engine.data());
+    QVERIFY(!second->qmlEngine()->property("leakedProperty").isValid());
+    QCOMPARE(evaluate(second, "typeof leakedGlobal"), QString("undefined"));
+
+    close(secondApp);
+}
+
+int main(int argc, char **argv)
+{
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+
+    QTemporaryDir storage;
+    setenv("XDG_DATA_HOME", QString("%1/data").arg(storage.path()).toUtf8().constData(), 0);
+    setenv("XDG_CACHE_HOME", QString("%1/cache").arg(storage.path()).toUtf8().constData(), 0);
+
+    WebAppManager webAppManager(argc, argv, new LocalServiceTransport);
+    sManager = &webAppManager;
+
+    WindowPoolTest test;
+    return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_windowpool.moc"